@@ -0,0 +1,8 @@
+
+// element wise ops on packed vecs
+
+a: @[u64 $ 1; u64 $ 2; u64 $ 3; u64 $ 4]
+b: @[u64 $ 10; u64 $ 20; u64 $ 30; u64 $ 40]
+
+1 <& @[a + b - u64 $ 1; "\n"]
+1 <& @[a <= u64 $ 2; "\n"]
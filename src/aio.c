@@ -0,0 +1,196 @@
+
+#define _GNU_SOURCE
+
+#include "aio.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+
+extern inline void aio_req_setup(aio_req *const req, aio_op op, int fd, void *const buf, size_t len, void (*wake)(void *arg), void *arg);
+
+static void complete(aio_req *const req, ssize_t result) {
+    req->result = result;
+    atomic_store_explicit(&req->done, true, memory_order_release);
+    if (req->wake != NULL) req->wake(req->arg);
+}
+
+static bool uring_init(aio *const a, size_t depth) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = syscall(__NR_io_uring_setup, (unsigned) depth, &p);
+    if (fd < 0) return false;
+    // reads and writes at the current position need 5.6
+    if ((p.features & IORING_FEAT_RW_CUR_POS) == 0 || (p.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+        close(fd);
+        return false;
+    }
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned), cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    a->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    a->ring = mmap(NULL, a->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (a->ring == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    a->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (a->sqes == MAP_FAILED) {
+        munmap(a->ring, a->ring_size);
+        close(fd);
+        return false;
+    }
+    uint8_t *ring = a->ring;
+    a->ring_fd = fd;
+    a->sq_entries = p.sq_entries;
+    a->cq_entries = p.cq_entries;
+    a->sq_head = (unsigned*) (ring + p.sq_off.head);
+    a->sq_tail = (unsigned*) (ring + p.sq_off.tail);
+    a->sq_mask = (unsigned*) (ring + p.sq_off.ring_mask);
+    a->sq_array = (unsigned*) (ring + p.sq_off.array);
+    a->cq_head = (unsigned*) (ring + p.cq_off.head);
+    a->cq_tail = (unsigned*) (ring + p.cq_off.tail);
+    a->cq_mask = (unsigned*) (ring + p.cq_off.ring_mask);
+    a->cqes = (struct io_uring_cqe*) (ring + p.cq_off.cqes);
+    return true;
+}
+
+aio *aio_init(size_t depth) {
+    aio *a = calloc(1, sizeof(aio));
+    a->ring_fd = a->epoll_fd = -1;
+    const char *env = getenv("SC_IO");
+    if ((env == NULL || strcmp(env, "epoll") != 0) && uring_init(a, depth) == true) {
+        a->backend = AIO_BACKEND_PFX(URING);
+        return a;
+    }
+    a->backend = AIO_BACKEND_PFX(EPOLL);
+    a->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return a;
+}
+
+void aio_free(aio *a) {
+    while (a->in_flight > 0) aio_poll(a, true);
+    if (a->backend == AIO_BACKEND_PFX(URING)) {
+        munmap(a->sqes, a->sq_entries * sizeof(struct io_uring_sqe));
+        munmap(a->ring, a->ring_size);
+        close(a->ring_fd);
+    } else if (a->epoll_fd >= 0) {
+        close(a->epoll_fd);
+    }
+    free(a);
+}
+
+static size_t uring_reap(aio *const a) {
+    size_t done = 0;
+    unsigned head = *a->cq_head;
+    while (head != __atomic_load_n(a->cq_tail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe *cqe = &a->cqes[head & *a->cq_mask];
+        aio_req *req = (aio_req*) (uintptr_t) cqe->user_data;
+        ssize_t res = cqe->res;
+        // the slot is given back before the wake can submit more
+        __atomic_store_n(a->cq_head, ++head, __ATOMIC_RELEASE);
+        a->in_flight--;
+        done++;
+        complete(req, res);
+    }
+    return done;
+}
+
+static void uring_submit(aio *const a, aio_req *const req) {
+    // completions are reaped first so the cq cannot overflow
+    while (a->in_flight >= a->cq_entries) aio_poll(a, true);
+    unsigned tail = *a->sq_tail, idx = tail & *a->sq_mask;
+    struct io_uring_sqe *sqe = &a->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = req->op == AIO_OP_PFX(READ) ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = req->fd;
+    sqe->addr = (uintptr_t) req->buf;
+    sqe->len = req->len;
+    sqe->off = (uint64_t) -1; // current position of the fd
+    sqe->user_data = (uintptr_t) req;
+    a->sq_array[idx] = idx;
+    __atomic_store_n(a->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    // a signal before the sqe is taken leaves it in the ring for the next try
+    int rc;
+    do {
+        rc = syscall(__NR_io_uring_enter, a->ring_fd, 1, 0, 0, NULL, 0);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) {
+        __atomic_store_n(a->sq_tail, tail, __ATOMIC_RELEASE);
+        complete(req, -errno);
+        return;
+    }
+    a->in_flight++;
+}
+
+static bool epoll_try(aio_req *const req) {
+    // false if the fd is not ready, a signal before any bytes moved tries again
+    ssize_t n;
+    do {
+        n = req->op == AIO_OP_PFX(READ) ? read(req->fd, req->buf, req->len) : write(req->fd, req->buf, req->len);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+    complete(req, n < 0 ? -errno : n);
+    return true;
+}
+
+static void epoll_arm(aio *const a, int fd) {
+    // one shot so only fds with waiting requests report
+    struct epoll_event ev = { .events = EPOLLONESHOT, .data.fd = fd };
+    for (aio_req *r = a->waiting; r != NULL; r = r->next)
+        if (r->fd == fd) ev.events |= r->op == AIO_OP_PFX(READ) ? EPOLLIN : EPOLLOUT;
+    if (epoll_ctl(a->epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0) epoll_ctl(a->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static size_t epoll_ready(aio *const a, int fd) {
+    size_t done = 0;
+    aio_req **link = &a->waiting;
+    while (*link != NULL) {
+        aio_req *r = *link;
+        if (r->fd != fd || epoll_try(r) == false) {
+            link = &r->next;
+            continue;
+        }
+        *link = r->next;
+        a->in_flight--;
+        done++;
+    }
+    for (aio_req *r = a->waiting; r != NULL; r = r->next) {
+        if (r->fd != fd) continue;
+        epoll_arm(a, fd);
+        break;
+    }
+    return done;
+}
+
+void aio_submit(aio *const a, aio_req *const req) {
+    if (a->backend == AIO_BACKEND_PFX(URING)) {
+        uring_submit(a, req);
+        return;
+    }
+    if (epoll_try(req) == true) return;
+    req->next = a->waiting;
+    a->waiting = req;
+    a->in_flight++;
+    epoll_arm(a, req->fd);
+}
+
+size_t aio_poll(aio *const a, bool wait) {
+    if (a->backend == AIO_BACKEND_PFX(URING)) {
+        size_t done = uring_reap(a);
+        if (done > 0 || wait == false || a->in_flight == 0) return done;
+        // an interrupted wait reaps nothing and the caller polls again, as epoll_wait does
+        syscall(__NR_io_uring_enter, a->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        return uring_reap(a);
+    }
+    struct epoll_event events[AIO_DEPTH];
+    if (a->in_flight == 0) return 0;
+    int n = epoll_wait(a->epoll_fd, events, AIO_DEPTH, wait == true ? -1 : 0);
+    size_t done = 0;
+    for (int i = 0; i < n; i++) done += epoll_ready(a, events[i].data.fd);
+    return done;
+}
+
+void aio_wait(aio *const a, aio_req *const req) {
+    while (atomic_load_explicit(&req->done, memory_order_acquire) == false) aio_poll(a, true);
+}
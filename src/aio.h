@@ -0,0 +1,71 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include <linux/io_uring.h>
+#include "def.h"
+
+#define AIO_OP_PFX(NAME) AIO_OP_##NAME
+
+typedef enum {
+    AIO_OP_PFX(READ),
+    AIO_OP_PFX(WRITE)
+} aio_op;
+
+typedef struct _aio_req {
+    aio_op op;
+    int fd;
+    void *buf;
+    size_t len;
+    ssize_t result; // bytes done or -errno
+    atomic_bool done;
+    void (*wake)(void *arg); // called on completion to resume whatever waits on the req, can be null
+    void *arg;
+    struct _aio_req *next; // waiting on readiness in the epoll fallback
+} aio_req;
+
+inline void aio_req_setup(aio_req *const req, aio_op op, int fd, void *const buf, size_t len, void (*wake)(void *arg), void *arg) {
+    req->op = op;
+    req->fd = fd;
+    req->buf = buf;
+    req->len = len;
+    req->result = 0;
+    atomic_init(&req->done, false);
+    req->wake = wake;
+    req->arg = arg;
+    req->next = NULL;
+}
+
+#define AIO_BACKEND_PFX(NAME) AIO_BACKEND_##NAME
+
+typedef enum {
+    AIO_BACKEND_PFX(URING),
+    AIO_BACKEND_PFX(EPOLL) // blocking fds complete on submit, nonblocking ones wait for readiness
+} aio_backend;
+
+typedef struct {
+    aio_backend backend;
+    size_t in_flight;
+    int ring_fd, epoll_fd;
+    void *ring;
+    size_t ring_size;
+    unsigned sq_entries, cq_entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array, *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    aio_req *waiting;
+} aio;
+
+aio *aio_init(size_t depth); // SC_IO=epoll skips io_uring
+
+void aio_free(aio *a); // waits for requests in flight
+
+void aio_submit(aio *const a, aio_req *const req);
+
+size_t aio_poll(aio *const a, bool wait); // runs completions, returns how many
+
+void aio_wait(aio *const a, aio_req *const req);
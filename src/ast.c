@@ -7,6 +7,7 @@ const char *ast_type_string(ast_type type) {
         "TYPE",
         "VAR",
         "INT",
+        "FLOAT",
         "CHAR",
         "VEC",
         "FN",
@@ -26,9 +27,31 @@ const char *ast_type_string(ast_type type) {
     return type > AST_PFX(_VALUE) && type < AST_PFX(_END_OP) ? types[type] : "AST_TYPE_NOT_FOUND";
 }
 
+const char *ast_alloc_string(ast_alloc alloc) {
+    static const char *allocs[] = {
+        "HEAP",
+        "FRAME",
+        "NONE",
+        "_END_ALLOC"
+    };
+    return alloc >= AST_ALLOC_PFX(HEAP) && alloc < AST_ALLOC_PFX(_END_ALLOC) ? allocs[alloc] : "AST_ALLOC_NOT_FOUND";
+}
+
+const char *ast_branch_kind_string(ast_branch_kind kind) {
+    static const char *kinds[] = {
+        "LINEAR",
+        "TREE",
+        "TABLE",
+        "_END_BRANCH"
+    };
+    return kind >= AST_BRANCH_PFX(LINEAR) && kind < AST_BRANCH_PFX(_END_BRANCH) ? kinds[kind] : "AST_BRANCH_NOT_FOUND";
+}
+
 extern inline ast_node *ast_node_init(ast_type type, ast_data data, const token *const t);
 
 void ast_node_free(ast_node *node) {
+    // ops are freed with a missing side when parsing stops part way
+    if (node == NULL) return;
     switch (node->type) {
         case AST_PFX(TYPE):
             var_type_free(node->data.type);
@@ -89,6 +112,14 @@ void ast_if_node_free(ast_if_node *if_node) {
         free(tmp);
     }
     ast_node_link_free(if_node->else_head);
+    if (if_node->branch != NULL) {
+        free(if_node->branch->starts);
+        free(if_node->branch->arms);
+        free(if_node->branch->table);
+        free(if_node->branch->conds);
+        free(if_node->branch->values);
+        free(if_node->branch);
+    }
     free(if_node);
 }
 
@@ -6,6 +6,7 @@
 #include "utf8.h"
 #include "def.h"
 #include "token.h"
+#include "var.h"
 
 #define AST_PFX(NAME) AST_##NAME
 
@@ -15,6 +16,7 @@ typedef enum {
     AST_PFX(TYPE),
     AST_PFX(VAR),
     AST_PFX(INT),
+    AST_PFX(FLOAT),
     AST_PFX(CHAR),
     AST_PFX(VEC),
     AST_PFX(FN),
@@ -33,8 +35,26 @@ typedef enum {
     AST_PFX(_END_OP)
 }  ast_type;
 
+#define AST_ALLOC_PFX(NAME) AST_ALLOC_##NAME
+
+// where the vec made by a node lives, set before run
+typedef enum {
+    AST_ALLOC_PFX(HEAP), // escapes the frame or is made on another thread
+    AST_ALLOC_PFX(FRAME), // in the region of the frame it is made in
+    AST_ALLOC_PFX(NONE), // never built, the items are used one at a time
+    AST_ALLOC_PFX(_END_ALLOC)
+} ast_alloc;
+
+const char *ast_alloc_string(ast_alloc alloc);
+
 typedef struct _ast_node ast_node;
 
+// where the fn running a node finds a var, set before run
+typedef struct {
+    bool env; // captured from an enclosing fn, idx is the slot in the env of the frame
+    size_t idx; // else the stack idx in the frame
+} ast_ref;
+
 typedef struct _ast_node_link {
     struct _ast_node_link *next; // TODO possible empty link at end with newlines
     ast_node *node;
@@ -43,6 +63,7 @@ typedef struct _ast_node_link {
 typedef struct {
     size_t num_items;
     var_type *type;
+    ast_alloc alloc;
     ast_node_link *items_head, *items_tail;
 } ast_vec_node;
 
@@ -50,14 +71,53 @@ typedef struct _ast_fn_node {
     var_type *type;
     struct _ast_fn_node *parent; // if null we are at the module level
     ast_node_link *body_head, *body_tail;
+    size_t num_captures;
+    symbol_table_bucket **captures; // vars of enclosing fns used by the body, the fns it makes or calls, set before run
+    ast_ref *refs; // where the parent finds each capture
+    var_closure *lifted; // the value of a fn with no captures, made once
 } ast_fn_node;
 
 typedef struct {
     size_t num_args;
+    bool fork; // args are independent pure calls, set before run
+    const ast_fn_node *target; // the only fn the var is assigned, called without reading the var, set before run
+    ast_ref *env; // where the caller finds each capture of the target
     ast_node *func;
     ast_node *args[];
 } ast_call_node;
 
+#define AST_BRANCH_PFX(NAME) AST_BRANCH_##NAME
+
+// how an if finds the arm to run, set before run
+typedef enum {
+    AST_BRANCH_PFX(LINEAR), // each cond in order
+    AST_BRANCH_PFX(TREE), // binary search of the ranges of the operand
+    AST_BRANCH_PFX(TABLE), // arm of each key between the first and last bound, keys outside are in the end ranges
+    AST_BRANCH_PFX(_END_BRANCH)
+} ast_branch_kind;
+
+const char *ast_branch_kind_string(ast_branch_kind kind);
+
+typedef struct _ast_if_cond ast_if_cond;
+
+typedef struct {
+    ast_branch_kind kind;
+    const char *reason; // why the kind was picked
+    size_t num_arms, linear_cost, tree_cost, table_cost; // nodes run to find the arm, table is 0 if none fits
+    bool select; // every arm is one constant so its value is returned without running a body
+    const ast_node *operand; // var compared by every cond
+    var_type_header header; // of the operand
+    uint64_t flip; // xor of each key so signed order is unsigned order
+    size_t num_ranges;
+    uint64_t *starts; // first key of each range, ranges cover every key in order
+    size_t *arms; // arm of each range, num_arms for the else
+    uint64_t base; // key of the first entry of the table, the start of the second range
+    size_t table_len;
+    uint8_t *table; // arm of each key from base
+    ast_if_cond **conds; // by arm
+    var_data *values; // by arm then the else if select
+} ast_branch;
+
 typedef struct _ast_if_cond {
     struct _ast_if_cond *next;
     ast_node *cond;
@@ -68,10 +128,15 @@ typedef struct {
     var_type *return_type; // added on infer, all bodies must have same type if if is being assigned
     ast_if_cond *conds_head, *conds_tail;
     ast_node_link *else_head, *else_tail;
+    ast_branch *branch; // null until marked
 } ast_if_node;
 
 typedef struct {
     var_type *return_type; // added on infer
+    bool fork; // sides are independent pure calls, set before run
+    bool fuse; // root of element wise vec ops run in one pass, set before run
+    ast_alloc alloc; // of a vec result
+    const ast_node *reuse; // leaf var whose vec holds the result when it has one owner, set before run
     ast_node *left, *right;
 } ast_op_node;
 
@@ -79,6 +144,7 @@ typedef union {
     var_type *type;
     symbol_table_bucket *var;
     int64_t intv;
+    double fv;
     utf8 cv;
     ast_vec_node *vec;
     ast_fn_node *fn;
@@ -90,6 +156,8 @@ typedef union {
 typedef struct _ast_node {
     ast_type type;
     ast_data data;
+    bool move; // a var read that takes the value out of the frame, set before run
+    ast_ref ref; // of a var, set before run
     token *t; // copy of token
 } ast_node;
 
@@ -143,6 +211,9 @@ inline ast_fn_node *ast_fn_node_init(ast_fn_node *parent) {
 
 inline void ast_fn_node_free(ast_fn_node *fn) {
     var_type_free(fn->type);
+    free(fn->captures);
+    free(fn->refs);
+    free(fn->lifted);
     //  parent is freed in the ast
     // free links
     ast_node_link_free(fn->body_head);
@@ -159,6 +230,7 @@ inline ast_call_node *ast_call_node_init(ast_node *const func, size_t num_args,
 }
 
 inline void ast_call_node_free(ast_call_node *c) {
+    free(c->env);
     ast_node_free(c->func);
     for (size_t i = 0; i < c->num_args; i++) ast_node_free(c->args[i]);
     free(c);
@@ -0,0 +1,216 @@
+#include "branch.h"
+
+#define BRANCH_BOUND_PFX(NAME) BRANCH_BOUND_##NAME
+
+typedef enum {
+    BRANCH_BOUND_PFX(EQUAL), // key = k
+    BRANCH_BOUND_PFX(AT_MOST), // key <= k
+    BRANCH_BOUND_PFX(AT_LEAST) // k <= key
+} branch_bound;
+
+typedef struct {
+    branch_bound bound;
+    uint64_t key;
+} branch_arm;
+
+static var_type_header header_of(const ast_node *const node) {
+    var_type type;
+    if (get_type_from_node(node, &type) == false) return VAR_PFX(UNKNOWN);
+    return type.header;
+}
+
+static bool const_value(const ast_node *const node, var_data *const data) {
+    // the value run_node gives for a literal or a cast of one
+    switch (node->type) {
+        case AST_PFX(INT):
+            data->i64 = node->data.intv;
+            return true;
+        case AST_PFX(FLOAT):
+            data->f64 = node->data.fv;
+            return true;
+        case AST_PFX(CHAR):
+            data->c = node->data.cv;
+            return true;
+        case AST_PFX(CAST):
+            if (const_value(node->data.op->right, data) == false) return false;
+            *data = var_data_cast(node->data.op->return_type->header, header_of(node->data.op->right), *data);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static const char *arm_of(const ast_node *const cond, const ast_node **const operand, branch_arm *const arm) {
+    // null if cond compares the operand to a constant, else why not
+    if (cond->type != AST_PFX(EQUAL) && cond->type != AST_PFX(LESSEQUAL)) return "a cond is not = or <=";
+    const ast_node *left = cond->data.op->left, *right = cond->data.op->right, *var = left, *k = right;
+    var_data data = { .u64 = 0 };
+    if (left->type != AST_PFX(VAR)) {
+        var = right;
+        k = left;
+    }
+    if (var->type != AST_PFX(VAR) || const_value(k, &data) == false) return "a cond does not compare a var to a constant";
+    if (*operand != NULL && (*operand)->data.var != var->data.var) return "conds compare different vars";
+    var_type_header header = header_of(var);
+    if (var_type_is_integer(header) == false && header != VAR_PFX(CHAR)) return "the var is not an integer";
+    *operand = var;
+    arm->key = var_data_to_u64(header, data);
+    if (cond->type == AST_PFX(EQUAL)) arm->bound = BRANCH_BOUND_PFX(EQUAL);
+    else arm->bound = var == left ? BRANCH_BOUND_PFX(AT_MOST) : BRANCH_BOUND_PFX(AT_LEAST);
+    return NULL;
+}
+
+static bool arm_holds(const branch_arm *const arm, uint64_t key) {
+    switch (arm->bound) {
+        case BRANCH_BOUND_PFX(EQUAL): return key == arm->key;
+        case BRANCH_BOUND_PFX(AT_MOST): return key <= arm->key;
+        default: return key >= arm->key;
+    }
+}
+
+static int key_cmp(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+static void set_ranges(ast_branch *const branch, const branch_arm *const arms) {
+    // every key where an arm starts or stops holding is the start of a range
+    size_t num = 1;
+    uint64_t *starts = malloc(sizeof(uint64_t) * (branch->num_arms * 2 + 1));
+    starts[0] = 0;
+    for (size_t i = 0; i < branch->num_arms; i++) {
+        if (arms[i].bound != BRANCH_BOUND_PFX(AT_MOST)) starts[num++] = arms[i].key;
+        if (arms[i].bound != BRANCH_BOUND_PFX(AT_LEAST) && arms[i].key != UINT64_MAX) starts[num++] = arms[i].key + 1;
+    }
+    qsort(starts, num, sizeof(uint64_t), key_cmp);
+    branch->starts = malloc(sizeof(uint64_t) * num);
+    branch->arms = malloc(sizeof(size_t) * num);
+    branch->num_ranges = 0;
+    for (size_t i = 0; i < num; i++) {
+        if (i > 0 && starts[i] == starts[i - 1]) continue;
+        size_t arm = 0;
+        while (arm < branch->num_arms && arm_holds(&arms[arm], starts[i]) == false) arm++;
+        // ranges next to each other with the same arm are one
+        if (branch->num_ranges > 0 && branch->arms[branch->num_ranges - 1] == arm) continue;
+        branch->starts[branch->num_ranges] = starts[i];
+        branch->arms[branch->num_ranges++] = arm;
+    }
+    free(starts);
+}
+
+static void set_table(ast_branch *const branch) {
+    // the end ranges are left out so a bound can be anywhere in the keys
+    if (branch->num_ranges < 3 || branch->num_arms >= UINT8_MAX) return;
+    uint64_t span = branch->starts[branch->num_ranges - 1] - branch->starts[1];
+    if (span > BRANCH_TABLE_MAX || span > BRANCH_TABLE_DENSITY * branch->num_ranges) return;
+    branch->base = branch->starts[1];
+    branch->table_len = span;
+    branch->table = malloc(span);
+    for (size_t r = 1; r + 1 < branch->num_ranges; r++)
+        for (uint64_t k = branch->starts[r]; k < branch->starts[r + 1]; k++) branch->table[k - branch->base] = branch->arms[r];
+    branch->table_cost = 3;
+}
+
+static bool body_value(ast_node_link *head, var_data *const data) {
+    // a body of one constant, an empty body is 0 like run_list gives
+    const ast_node *node = NULL;
+    data->u64 = 0;
+    for (; head != NULL; head = head->next) {
+        if (head->node == NULL) continue;
+        if (node != NULL) return false;
+        node = head->node;
+    }
+    return node == NULL || const_value(node, data);
+}
+
+static void set_select(ast_branch *const branch, const ast_if_node *const if_node) {
+    branch->values = malloc(sizeof(var_data) * (branch->num_arms + 1));
+    branch->select = body_value(if_node->else_head, &branch->values[branch->num_arms]);
+    for (size_t i = 0; i < branch->num_arms && branch->select == true; i++) branch->select = body_value(branch->conds[i]->body_head, &branch->values[i]);
+    if (branch->select == true) return;
+    free(branch->values);
+    branch->values = NULL;
+}
+
+static size_t log2_ceil(size_t n) {
+    size_t l = 0;
+    while (((size_t) 1 << l) < n) l++;
+    return l;
+}
+
+static void lower(ast_if_node *const if_node, branch_stats *const stats) {
+    ast_branch *branch = calloc(1, sizeof(ast_branch));
+    if_node->branch = branch;
+    for (ast_if_cond *c = if_node->conds_head; c != NULL; c = c->next) branch->num_arms++;
+    branch->linear_cost = branch->num_arms * 3;
+    branch->conds = malloc(sizeof(ast_if_cond*) * (branch->num_arms + 1));
+    branch_arm *arms = malloc(sizeof(branch_arm) * (branch->num_arms + 1));
+    size_t i = 0;
+    for (ast_if_cond *c = if_node->conds_head; c != NULL; c = c->next) branch->conds[i++] = c;
+    for (i = 0; i < branch->num_arms && branch->reason == NULL; i++) branch->reason = arm_of(branch->conds[i]->cond, &branch->operand, &arms[i]);
+    if (branch->num_arms == 0) branch->reason = "no conds";
+    if (branch->reason == NULL) {
+        branch->header = header_of(branch->operand);
+        if (var_type_is_signed(branch->header)) branch->flip = (uint64_t) 1 << 63;
+        for (i = 0; i < branch->num_arms; i++) arms[i].key ^= branch->flip;
+        set_ranges(branch, arms);
+        branch->tree_cost = 1 + log2_ceil(branch->num_ranges);
+        set_table(branch);
+        set_select(branch, if_node);
+        if (branch->table != NULL && branch->table_cost < branch->tree_cost && branch->table_cost < branch->linear_cost) {
+            branch->kind = AST_BRANCH_PFX(TABLE);
+            branch->reason = "dense bounds";
+        } else if (branch->tree_cost < branch->linear_cost) {
+            branch->kind = AST_BRANCH_PFX(TREE);
+            branch->reason = "fewer compares than the conds";
+        } else {
+            branch->reason = "the conds are cheapest";
+        }
+    }
+    free(arms);
+    if (branch->kind == AST_BRANCH_PFX(LINEAR)) branch->select = false;
+    if (stats == NULL) return;
+    stats->ifs++;
+    if (branch->kind == AST_BRANCH_PFX(LINEAR)) stats->linear++;
+    else if (branch->kind == AST_BRANCH_PFX(TREE)) stats->tree++;
+    else stats->table++;
+    if (branch->select == true) stats->select++;
+}
+
+static void mark_node(ast_node *const node, branch_stats *const stats);
+
+static void mark_list(ast_node_link *head, branch_stats *const stats) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) mark_node(head->node, stats);
+}
+
+static void mark_node(ast_node *const node, branch_stats *const stats) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            mark_list(node->data.vec->items_head, stats);
+            break;
+        case AST_PFX(FN):
+            mark_list(node->data.fn->body_head, stats);
+            break;
+        case AST_PFX(CALL):
+            for (size_t i = 0; i < node->data.call->num_args; i++) mark_node(node->data.call->args[i], stats);
+            break;
+        case AST_PFX(IF):
+            lower(node->data.ifn, stats);
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(c->cond, stats);
+                mark_list(c->body_head, stats);
+            }
+            mark_list(node->data.ifn->else_head, stats);
+            break;
+        default:
+            if (is_op(node) == false) break;
+            mark_node(node->data.op->left, stats);
+            mark_node(node->data.op->right, stats);
+            break;
+    }
+}
+
+void branch_mark(ast_fn_node *const root, branch_stats *const stats) {
+    mark_list(root->body_head, stats);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ast.h"
+#include "infer.h"
+
+typedef struct {
+    size_t ifs, linear, tree, table, select;
+} branch_stats;
+
+// ifs whose conds all compare one integer var to constants with = or <= are lowered
+// the conds split the keys into ranges, each taking the first arm that holds it
+// a cond costs 3 nodes run, the operand 1 and a bound 1
+// linear runs 3 per arm, a tree 1 + log2 ranges, a table 3 when the bounds span at most
+// BRANCH_TABLE_MAX keys and BRANCH_TABLE_DENSITY keys per range, the cheapest is picked
+// arms that are one constant are selected from a list of values instead of run
+void branch_mark(ast_fn_node *const root, branch_stats *const stats); // stats can be null
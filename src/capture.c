@@ -0,0 +1,218 @@
+#include "capture.h"
+
+typedef struct {
+    const symbol_table_bucket *var;
+    ast_fn_node *fn; // last fn assigned to var
+    size_t assigns;
+} capture_known;
+
+typedef struct {
+    size_t num_fns, num_calls, num_known;
+    ast_fn_node **fns;
+    ast_call_node **calls;
+    capture_known *known;
+} capture_state;
+
+static void *grow(void *items, size_t len, size_t item_size) {
+    // lists start with 4 and double when full
+    if (len == 0) return realloc(items, item_size * 4);
+    if (len >= 4 && (len & (len - 1)) == 0) return realloc(items, item_size * len * 2);
+    return items;
+}
+
+static void collect_assign(capture_state *const state, const ast_node *const node) {
+    const symbol_table_bucket *var = node->data.op->left->data.var;
+    ast_fn_node *fn = node->data.op->right->type == AST_PFX(FN) ? node->data.op->right->data.fn : NULL;
+    for (size_t i = 0; i < state->num_known; i++) {
+        if (state->known[i].var != var) continue;
+        state->known[i].assigns++;
+        state->known[i].fn = fn;
+        return;
+    }
+    state->known = grow(state->known, state->num_known, sizeof(capture_known));
+    state->known[state->num_known++] = (capture_known) { .var = var, .fn = fn, .assigns = 1 };
+}
+
+static void collect(capture_state *const state, ast_node *const node);
+
+static void collect_list(capture_state *const state, ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) collect(state, head->node);
+}
+
+static void collect(capture_state *const state, ast_node *const node) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            collect_list(state, node->data.vec->items_head);
+            break;
+        case AST_PFX(FN):
+            state->fns = grow(state->fns, state->num_fns, sizeof(ast_fn_node*));
+            state->fns[state->num_fns++] = node->data.fn;
+            collect_list(state, node->data.fn->body_head);
+            break;
+        case AST_PFX(CALL):
+            state->calls = grow(state->calls, state->num_calls, sizeof(ast_call_node*));
+            state->calls[state->num_calls++] = node->data.call;
+            for (size_t i = 0; i < node->data.call->num_args; i++) collect(state, node->data.call->args[i]);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                collect(state, c->cond);
+                collect_list(state, c->body_head);
+            }
+            collect_list(state, node->data.ifn->else_head);
+            break;
+        default:
+            if (is_op(node) == false) break;
+            if (node->type == AST_PFX(ASSIGN) && node->data.op->left->type == AST_PFX(VAR)) collect_assign(state, node);
+            collect(state, node->data.op->left);
+            collect(state, node->data.op->right);
+            break;
+    }
+}
+
+static bool has_capture(const ast_fn_node *const fn, const symbol_table_bucket *const var, size_t *const idx) {
+    for (size_t i = 0; i < fn->num_captures; i++) {
+        if (fn->captures[i] != var) continue;
+        if (idx != NULL) *idx = i;
+        return true;
+    }
+    return false;
+}
+
+static bool add_capture(ast_fn_node *const fn, symbol_table_bucket *const var) {
+    if (symbol_table_has_bucket(fn->type->body.fn->symbols, var) == true || has_capture(fn, var, NULL) == true) return false;
+    fn->captures = grow(fn->captures, fn->num_captures, sizeof(symbol_table_bucket*));
+    fn->captures[fn->num_captures++] = var;
+    return true;
+}
+
+static bool add_captures_of(ast_fn_node *const fn, const ast_fn_node *const inner) {
+    bool added = false;
+    for (size_t i = 0; i < inner->num_captures; i++) added = add_capture(fn, inner->captures[i]) || added;
+    return added;
+}
+
+static bool free_vars(ast_fn_node *const fn, const ast_node *const node);
+
+static bool free_vars_list(ast_fn_node *const fn, const ast_node_link *head) {
+    bool added = false;
+    for (; head != NULL; head = head->next) if (head->node != NULL) added = free_vars(fn, head->node) || added;
+    return added;
+}
+
+static bool free_vars(ast_fn_node *const fn, const ast_node *const node) {
+    // true if a capture was added to fn, nested fns give what they capture that fn does not have
+    bool added = false;
+    if (node == NULL) return false;
+    switch (node->type) {
+        case AST_PFX(VAR):
+            return add_capture(fn, node->data.var);
+        case AST_PFX(VEC):
+            return free_vars_list(fn, node->data.vec->items_head);
+        case AST_PFX(FN):
+            return add_captures_of(fn, node->data.fn);
+        case AST_PFX(CALL):
+            // a known fn is not read, the caller needs its captures instead
+            if (node->data.call->target != NULL) added = add_captures_of(fn, node->data.call->target);
+            else added = free_vars(fn, node->data.call->func);
+            for (size_t i = 0; i < node->data.call->num_args; i++) added = free_vars(fn, node->data.call->args[i]) || added;
+            return added;
+        case AST_PFX(IF):
+            for (const ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                added = free_vars(fn, c->cond) || added;
+                added = free_vars_list(fn, c->body_head) || added;
+            }
+            return free_vars_list(fn, node->data.ifn->else_head) || added;
+        default:
+            if (is_op(node) == false) return false;
+            added = free_vars(fn, node->data.op->left);
+            return free_vars(fn, node->data.op->right) || added;
+    }
+}
+
+static ast_ref resolve(const ast_fn_node *const fn, const symbol_table_bucket *const var) {
+    size_t idx = 0;
+    if (has_capture(fn, var, &idx) == true) return (ast_ref) { .env = true, .idx = idx };
+    return (ast_ref) { .env = false, .idx = var->idx.stack };
+}
+
+static ast_ref *resolve_all(const ast_fn_node *const fn, const ast_fn_node *const inner) {
+    ast_ref *refs = malloc(sizeof(ast_ref) * (inner->num_captures + 1));
+    for (size_t i = 0; i < inner->num_captures; i++) refs[i] = resolve(fn, inner->captures[i]);
+    return refs;
+}
+
+static void set_refs(const ast_fn_node *const fn, ast_node *const node);
+
+static void set_refs_list(const ast_fn_node *const fn, ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) set_refs(fn, head->node);
+}
+
+static void set_refs(const ast_fn_node *const fn, ast_node *const node) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VAR):
+            node->ref = resolve(fn, node->data.var);
+            break;
+        case AST_PFX(VEC):
+            set_refs_list(fn, node->data.vec->items_head);
+            break;
+        case AST_PFX(FN):
+            // the body is set by the fn itself
+            node->data.fn->refs = resolve_all(fn, node->data.fn);
+            break;
+        case AST_PFX(CALL):
+            set_refs(fn, node->data.call->func);
+            if (node->data.call->target != NULL) node->data.call->env = resolve_all(fn, node->data.call->target);
+            for (size_t i = 0; i < node->data.call->num_args; i++) set_refs(fn, node->data.call->args[i]);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                set_refs(fn, c->cond);
+                set_refs_list(fn, c->body_head);
+            }
+            set_refs_list(fn, node->data.ifn->else_head);
+            break;
+        default:
+            if (is_op(node) == false) break;
+            set_refs(fn, node->data.op->left);
+            set_refs(fn, node->data.op->right);
+            break;
+    }
+}
+
+void capture_mark(ast_fn_node *const root, capture_stats *const stats) {
+    capture_state state = { .num_fns = 0 };
+    state.fns = grow(NULL, 0, sizeof(ast_fn_node*));
+    state.fns[state.num_fns++] = root;
+    collect_list(&state, root->body_head);
+    for (size_t i = 0; i < state.num_calls; i++) {
+        ast_call_node *call = state.calls[i];
+        if (call->func->type != AST_PFX(VAR)) continue;
+        for (size_t k = 0; k < state.num_known; k++)
+            if (state.known[k].var == call->func->data.var && state.known[k].assigns == 1) call->target = state.known[k].fn;
+    }
+    // captures only grow so this ends, calls between fns need more than one pass
+    bool added = true;
+    while (added == true) {
+        added = false;
+        for (size_t i = 0; i < state.num_fns; i++) added = free_vars_list(state.fns[i], state.fns[i]->body_head) || added;
+    }
+    for (size_t i = 0; i < state.num_fns; i++) {
+        ast_fn_node *fn = state.fns[i];
+        set_refs_list(fn, fn->body_head);
+        if (fn->num_captures == 0 && fn != root) {
+            fn->lifted = malloc(sizeof(var_closure));
+            fn->lifted->fn = fn;
+        }
+        if (stats == NULL || fn == root) continue;
+        stats->fns++;
+        stats->captures += fn->num_captures;
+        if (fn->num_captures == 0) stats->lifted++;
+    }
+    for (size_t i = 0; stats != NULL && i < state.num_calls; i++) if (state.calls[i]->target != NULL) stats->known_calls++;
+    free(state.fns);
+    free(state.calls);
+    free(state.known);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ast.h"
+#include "var.h"
+
+typedef struct {
+    size_t fns, lifted, captures, known_calls;
+} capture_stats;
+
+// gives each fn the vars of enclosing fns it needs, the frame of a call holds pointers to them in a flat env
+// a var only assigned one fn is a known fn, calls of it take the env from the slots of the caller without reading the var
+// a fn with no captures is lifted, its value is made once and its calls copy nothing
+// every var read is then a slot of the frame or one load through its env
+void capture_mark(ast_fn_node *const root, capture_stats *const stats); // stats can be null
@@ -0,0 +1,254 @@
+#include "chan.h"
+
+static void waiters_init(chan_waiters *const w) {
+    atomic_flag_clear(&w->lock);
+    atomic_init(&w->num, 0);
+    w->head = NULL;
+}
+
+static chan *chan_alloc(pool *const p, chan_kind kind) {
+    chan *c = slab_alloc(sizeof(chan));
+    if (c == NULL) return NULL;
+    memset(c, 0, sizeof(chan));
+    c->kind = kind;
+    c->p = p;
+    atomic_init(&c->closed, false);
+    atomic_init(&c->send_pos, 0);
+    atomic_init(&c->recv_pos, 0);
+    waiters_init(&c->senders);
+    waiters_init(&c->receivers);
+    return c;
+}
+
+chan *chan_init(pool *const p, size_t cap) {
+    size_t size = 2;
+    while (size < cap) size *= 2;
+    chan *c = chan_alloc(p, CHAN_KIND_PFX(MPMC));
+    if (c == NULL) return NULL;
+    c->ring.mask = size - 1;
+    if ((c->ring.slots = slab_alloc(sizeof(chan_slot) * size)) == NULL) {
+        slab_free(c, sizeof(chan));
+        return NULL;
+    }
+    for (size_t i = 0; i < size; i++) atomic_init(&c->ring.slots[i].seq, i);
+    return c;
+}
+
+static chan_block *block_init(void) {
+    chan_block *b = slab_alloc(sizeof(chan_block));
+    if (b != NULL) atomic_init(&b->next, NULL);
+    return b;
+}
+
+chan *chan_init_spsc(pool *const p) {
+    chan *c = chan_alloc(p, CHAN_KIND_PFX(SPSC));
+    if (c == NULL) return NULL;
+    if ((c->list.send_block = c->list.recv_block = block_init()) == NULL) {
+        slab_free(c, sizeof(chan));
+        return NULL;
+    }
+    atomic_init(&c->list.spare, NULL);
+    return c;
+}
+
+void chan_free(chan *c) {
+    if (c->kind == CHAN_KIND_PFX(MPMC)) {
+        slab_free(c->ring.slots, sizeof(chan_slot) * (c->ring.mask + 1));
+    } else {
+        chan_block *b = c->list.recv_block;
+        while (b != NULL) {
+            chan_block *next = atomic_load_explicit(&b->next, memory_order_relaxed);
+            slab_free(b, sizeof(chan_block));
+            b = next;
+        }
+        slab_free(atomic_load_explicit(&c->list.spare, memory_order_relaxed), sizeof(chan_block));
+    }
+    slab_free(c, sizeof(chan));
+}
+
+// vyukov, a slot seq says whose turn it is so senders and receivers only contend on their own pos
+
+static bool ring_send(chan *const c, var_data data) {
+    size_t pos = atomic_load_explicit(&c->send_pos, memory_order_relaxed);
+    chan_slot *slot;
+    for (;;) {
+        slot = &c->ring.slots[pos & c->ring.mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&c->send_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&c->send_pos, memory_order_relaxed);
+        }
+    }
+    slot->data = data;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool ring_recv(chan *const c, var_data *const data) {
+    size_t pos = atomic_load_explicit(&c->recv_pos, memory_order_relaxed);
+    chan_slot *slot;
+    for (;;) {
+        slot = &c->ring.slots[pos & c->ring.mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&c->recv_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&c->recv_pos, memory_order_relaxed);
+        }
+    }
+    *data = slot->data;
+    // free for the sender one lap later
+    atomic_store_explicit(&slot->seq, pos + c->ring.mask + 1, memory_order_release);
+    return true;
+}
+
+// the sender fills the last block and links a new one before publishing the pos past it
+
+static bool list_send(chan *const c, var_data data) {
+    size_t pos = atomic_load_explicit(&c->send_pos, memory_order_relaxed);
+    chan_block *b = c->list.send_block;
+    b->items[pos % CHAN_BLOCK_SIZE] = data;
+    if ((pos + 1) % CHAN_BLOCK_SIZE == 0) {
+        chan_block *next = atomic_exchange_explicit(&c->list.spare, NULL, memory_order_acquire);
+        if (next == NULL && (next = block_init()) == NULL) return false;
+        atomic_store_explicit(&next->next, NULL, memory_order_relaxed);
+        atomic_store_explicit(&b->next, next, memory_order_relaxed);
+        c->list.send_block = next;
+    }
+    atomic_store_explicit(&c->send_pos, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool list_recv(chan *const c, var_data *const data) {
+    size_t pos = atomic_load_explicit(&c->recv_pos, memory_order_relaxed);
+    if (pos == atomic_load_explicit(&c->send_pos, memory_order_acquire)) return false;
+    chan_block *b = c->list.recv_block;
+    *data = b->items[pos % CHAN_BLOCK_SIZE];
+    if ((pos + 1) % CHAN_BLOCK_SIZE == 0) {
+        c->list.recv_block = atomic_load_explicit(&b->next, memory_order_relaxed);
+        slab_free(atomic_exchange_explicit(&c->list.spare, b, memory_order_release), sizeof(chan_block));
+    }
+    atomic_store_explicit(&c->recv_pos, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+static bool chan_can_send(chan *const c) {
+    if (atomic_load(&c->closed) || c->kind == CHAN_KIND_PFX(SPSC)) return true;
+    size_t pos = atomic_load(&c->send_pos);
+    return atomic_load(&c->ring.slots[pos & c->ring.mask].seq) == pos;
+}
+
+static bool chan_can_recv(chan *const c) {
+    if (atomic_load(&c->closed)) return true;
+    size_t pos = atomic_load(&c->recv_pos);
+    if (c->kind == CHAN_KIND_PFX(SPSC)) return pos != atomic_load(&c->send_pos);
+    return atomic_load(&c->ring.slots[pos & c->ring.mask].seq) == pos + 1;
+}
+
+static void waiters_lock(chan_waiters *const w) {
+    while (atomic_flag_test_and_set_explicit(&w->lock, memory_order_acquire)) sched_yield();
+}
+
+static void waiters_unlock(chan_waiters *const w) {
+    atomic_flag_clear_explicit(&w->lock, memory_order_release);
+}
+
+static void chan_wake(chan_waiters *const w, bool all) {
+    // pairs with the fence in chan_park, either the waiter sees the change or this sees the waiter
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&w->num, memory_order_relaxed) == 0) return;
+    waiters_lock(w);
+    thread *head = w->head;
+    if (head != NULL) {
+        if (all) {
+            w->head = NULL;
+            atomic_store_explicit(&w->num, 0, memory_order_relaxed);
+        } else {
+            w->head = head->next_waiter;
+            head->next_waiter = NULL;
+            atomic_fetch_sub_explicit(&w->num, 1, memory_order_relaxed);
+        }
+    }
+    waiters_unlock(w);
+    while (head != NULL) {
+        thread *next = head->next_waiter;
+        thread_ready(head);
+        head = next;
+    }
+}
+
+typedef struct {
+    chan *c;
+    chan_waiters *w;
+    bool (*can)(chan *const c);
+} chan_park_arg;
+
+static void chan_park(thread *t, void *arg) {
+    chan_park_arg *a = arg;
+    waiters_lock(a->w);
+    atomic_fetch_add_explicit(&a->w->num, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (a->can(a->c)) {
+        // changed while switching out
+        atomic_fetch_sub_explicit(&a->w->num, 1, memory_order_relaxed);
+        waiters_unlock(a->w);
+        thread_ready(t);
+        return;
+    }
+    t->next_waiter = a->w->head;
+    a->w->head = t;
+    waiters_unlock(a->w);
+}
+
+static void chan_wait(chan *const c, chan_waiters *const w, bool (*can)(chan *const c)) {
+    if (thread_current() != NULL) {
+        chan_park_arg a = { .c = c, .w = w, .can = can };
+        thread_park(chan_park, &a);
+        return;
+    }
+    // not a green thread, run tasks so the threads on the other side get to run
+    while (can(c) == false) if (c->p == NULL || pool_help(c->p) == false) sched_yield();
+}
+
+bool chan_try_send(chan *const c, var_data data) {
+    if (atomic_load_explicit(&c->closed, memory_order_relaxed)) return false;
+    if ((c->kind == CHAN_KIND_PFX(MPMC) ? ring_send(c, data) : list_send(c, data)) == false) return false;
+    chan_wake(&c->receivers, false);
+    return true;
+}
+
+bool chan_try_recv(chan *const c, var_data *const data) {
+    if ((c->kind == CHAN_KIND_PFX(MPMC) ? ring_recv(c, data) : list_recv(c, data)) == false) return false;
+    if (c->kind == CHAN_KIND_PFX(MPMC)) chan_wake(&c->senders, false);
+    return true;
+}
+
+bool chan_send(chan *const c, var_data data) {
+    for (;;) {
+        if (chan_try_send(c, data)) return true;
+        if (atomic_load(&c->closed)) return false;
+        chan_wait(c, &c->senders, chan_can_send);
+    }
+}
+
+bool chan_recv(chan *const c, var_data *const data) {
+    for (;;) {
+        if (chan_try_recv(c, data)) return true;
+        // values sent before the close are still received
+        if (atomic_load(&c->closed)) return chan_try_recv(c, data);
+        chan_wait(c, &c->receivers, chan_can_recv);
+    }
+}
+
+void chan_close(chan *const c) {
+    atomic_store(&c->closed, true);
+    chan_wake(&c->senders, true);
+    chan_wake(&c->receivers, true);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "def.h"
+#include "slab.h"
+#include "var.h"
+#include "thread.h"
+
+#define CHAN_KIND_PFX(NAME) CHAN_KIND_##NAME
+
+typedef enum {
+    CHAN_KIND_PFX(MPMC), // bounded ring, any number of senders and receivers
+    CHAN_KIND_PFX(SPSC) // unbounded, one sender and one receiver
+} chan_kind;
+
+typedef struct {
+    atomic_size_t seq; // pos when free to send, pos + 1 when it holds a value
+    var_data data;
+} chan_slot;
+
+typedef struct _chan_block {
+    _Atomic(struct _chan_block*) next;
+    var_data items[CHAN_BLOCK_SIZE];
+} chan_block;
+
+typedef struct {
+    atomic_flag lock; // only held to add or take a parked thread
+    atomic_size_t num; // parked or about to park
+    thread *head;
+} chan_waiters;
+
+typedef struct {
+    chan_kind kind;
+    pool *p; // helped by callers that are not green threads
+    atomic_bool closed;
+    union {
+        struct {
+            size_t mask;
+            chan_slot *slots;
+        } ring;
+        struct {
+            chan_block *send_block, *recv_block;
+            _Atomic(chan_block*) spare; // last block the receiver finished, reused by the sender
+        } list;
+    };
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t send_pos;
+    _Alignas(CACHE_LINE_SIZE) atomic_size_t recv_pos;
+    _Alignas(CACHE_LINE_SIZE) chan_waiters senders;
+    _Alignas(CACHE_LINE_SIZE) chan_waiters receivers;
+} chan;
+
+chan *chan_init(pool *const p, size_t cap); // mpmc, cap is rounded up to a power of 2
+
+chan *chan_init_spsc(pool *const p);
+
+void chan_free(chan *c); // values still in the chan are not freed
+
+bool chan_try_send(chan *const c, var_data data); // false if full or closed
+
+bool chan_try_recv(chan *const c, var_data *const data); // false if empty
+
+bool chan_send(chan *const c, var_data data); // parks while full, false if closed
+
+bool chan_recv(chan *const c, var_data *const data); // parks while empty, false once closed and empty
+
+void chan_close(chan *const c); // wakes everything parked on the chan
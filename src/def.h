@@ -13,8 +13,28 @@
     #define DEFAULT_HASH_SIZE 10
 #endif
 
-#ifndef MAX_REHASH
-    #define MAX_REHASH 5
+#ifndef HASH_GROUP_SIZE
+    #define HASH_GROUP_SIZE 16
+#endif
+
+#ifndef HASH_MAX_LOAD_PERCENT
+    #define HASH_MAX_LOAD_PERCENT 87
+#endif
+
+#ifndef HASH_INLINE_KEY
+    #define HASH_INLINE_KEY 16
+#endif
+
+#ifndef PVEC_BITS
+    #define PVEC_BITS 5
+#endif
+
+#ifndef HASH_PERFECT_BUCKET_KEYS
+    #define HASH_PERFECT_BUCKET_KEYS 2
+#endif
+
+#ifndef HASH_PERFECT_MAX_SEED
+    #define HASH_PERFECT_MAX_SEED 4096
 #endif
 
 #ifndef REHASH_SIZE_MULTIPLIER
@@ -29,10 +49,146 @@
     #define ERROR_INFER_MAX_STACK_SIZE 20
 #endif
 
-#ifndef IR_MAX_FN_STACK
-    #define IR_MAX_FN_STACK 5
+#ifndef POOL_MAX_WORKERS
+    #define POOL_MAX_WORKERS 64
+#endif
+
+#ifndef POOL_STACK_SIZE
+    #define POOL_STACK_SIZE 268435456
+#endif
+
+#ifndef POOL_DEQUE_SIZE
+    #define POOL_DEQUE_SIZE 1024
+#endif
+
+#ifndef RUN_STACK_SIZE
+    #define RUN_STACK_SIZE 1073741824
+#endif
+
+#ifndef RUN_FORK_EXTRA_DEPTH
+    #define RUN_FORK_EXTRA_DEPTH 4
+#endif
+
+#ifndef VEC_SIMD_BYTES
+    #define VEC_SIMD_BYTES 32
+#endif
+
+#ifndef VEC_DEFAULT_SIZE
+    #define VEC_DEFAULT_SIZE 8
+#endif
+
+#ifndef RUN_FUSE_CHUNK
+    #define RUN_FUSE_CHUNK 512
+#endif
+
+#ifndef CACHE_LINE_SIZE
+    #define CACHE_LINE_SIZE 64
+#endif
+
+#ifndef RUN_PARALLEL_MIN_ITEMS
+    #define RUN_PARALLEL_MIN_ITEMS 65536
+#endif
+
+#ifndef RUN_PARALLEL_GRAIN
+    #define RUN_PARALLEL_GRAIN 8192
+#endif
+
+#ifndef ROPE_SMALL_LEN
+    #define ROPE_SMALL_LEN 24
+#endif
+
+#ifndef ROPE_LEAF_LEN
+    #define ROPE_LEAF_LEN 256
+#endif
+
+#ifndef ROPE_MAX_DEPTH
+    #define ROPE_MAX_DEPTH 48
+#endif
+
+#ifndef ROPE_WRITE_IOV
+    #define ROPE_WRITE_IOV 64
+#endif
+
+#ifndef OUT_BUF_SIZE
+    #define OUT_BUF_SIZE 16384
+#endif
+
+#ifndef OUT_MAX_FDS
+    #define OUT_MAX_FDS 16
+#endif
+
+#ifndef AIO_DEPTH
+    #define AIO_DEPTH 64
+#endif
+
+#ifndef FILE_TRANSFER_CHUNK
+    #define FILE_TRANSFER_CHUNK 1073741824
+#endif
+
+#ifndef THREAD_STACK_SIZE
+    #define THREAD_STACK_SIZE 262144
+#endif
+
+#ifndef THREAD_MAX_FREE_STACKS
+    #define THREAD_MAX_FREE_STACKS 256
+#endif
+
+#ifndef CHAN_BLOCK_SIZE
+    #define CHAN_BLOCK_SIZE 256
+#endif
+
+#ifndef IR_CORO_FRAME_CHUNK
+    #define IR_CORO_FRAME_CHUNK 1024
+#endif
+
+#ifndef REGEX_MAX_NFA
+    #define REGEX_MAX_NFA 65536
+#endif
+
+#ifndef REGEX_DFA_CACHE_SIZE
+    #define REGEX_DFA_CACHE_SIZE 1048576
+#endif
+
+#ifndef REGEX_DFA_MAX_FLUSHES
+    #define REGEX_DFA_MAX_FLUSHES 8
+#endif
+
+#ifndef REGION_CHUNK_SIZE
+    #define REGION_CHUNK_SIZE 4096
+#endif
+
+#ifndef SLAB_SIZE
+    #define SLAB_SIZE 65536
+#endif
+
+#ifndef SLAB_LARGE_SIZE
+    #define SLAB_LARGE_SIZE 2097152
+#endif
+
+#ifndef SLAB_LARGE_MIN_CLASS
+    #define SLAB_LARGE_MIN_CLASS 1024
+#endif
+
+#ifndef SLAB_HUGE_PAGES
+    #define SLAB_HUGE_PAGES 1
+#endif
+
+#ifndef SLAB_BATCH_BYTES
+    #define SLAB_BATCH_BYTES 16384
+#endif
+
+#ifndef STACK_SEGMENT_SIZE
+    #define STACK_SEGMENT_SIZE 65536
+#endif
+
+#ifndef STACK_NATIVE_MARGIN
+    #define STACK_NATIVE_MARGIN 262144
+#endif
+
+#ifndef BRANCH_TABLE_MAX
+    #define BRANCH_TABLE_MAX 256
 #endif
 
-#ifndef IR_FN_MAX_LOCAL_STACK_SIZE
-    #define IR_FN_MAX_LOCAL_STACK_SIZE 30
+#ifndef BRANCH_TABLE_DENSITY
+    #define BRANCH_TABLE_DENSITY 4
 #endif
@@ -0,0 +1,133 @@
+#include "escape.h"
+
+typedef struct {
+    const ast_fn_node *fn;
+    escape_stats *stats;
+} escape_state;
+
+static void set_alloc(escape_state *const state, ast_alloc *const alloc, ast_alloc to) {
+    *alloc = to;
+    if (state->stats == NULL) return;
+    switch (to) {
+        case AST_ALLOC_PFX(HEAP):
+            state->stats->heap++;
+            break;
+        case AST_ALLOC_PFX(FRAME):
+            state->stats->frame++;
+            break;
+        default:
+            state->stats->none++;
+            break;
+    }
+}
+
+static ast_alloc held_alloc(bool escapes, bool forked) {
+    // forked nodes run with the frame on another thread so they can not use its region
+    return escapes == true || forked == true ? AST_ALLOC_PFX(HEAP) : AST_ALLOC_PFX(FRAME);
+}
+
+static void mark_node(escape_state *const state, ast_node *const node, bool escapes, bool dropped, bool forked);
+
+static void mark_list(escape_state *const state, ast_node_link *head, bool escapes, bool dropped, bool forked) {
+    // only the last value leaves the list, the rest are dropped
+    for (; head != NULL; head = head->next) {
+        if (head->node == NULL) continue;
+        if (head->next == NULL || head->next->node == NULL) mark_node(state, head->node, escapes, dropped, forked);
+        else mark_node(state, head->node, false, true, forked);
+    }
+}
+
+static void mark_fn(escape_state *const state, const ast_fn_node *const fn) {
+    // the body runs in its own frame
+    escape_state fn_state = { .fn = fn, .stats = state->stats };
+    mark_list(&fn_state, fn->body_head, true, false, false);
+}
+
+static void mark_chain(escape_state *const state, ast_node *const node, bool forked) {
+    // ops inside a fused chain are run a chunk at a time by the root, the leaves are operands
+    if (fuse_is_vec_op(node) == false) {
+        mark_node(state, node, false, false, forked);
+        return;
+    }
+    set_alloc(state, &node->data.op->alloc, AST_ALLOC_PFX(NONE));
+    mark_chain(state, node->data.op->left, forked);
+    mark_chain(state, node->data.op->right, forked);
+}
+
+static void mark_vec_op(escape_state *const state, ast_node *const node, ast_alloc alloc, bool forked) {
+    set_alloc(state, &node->data.op->alloc, alloc);
+    ast_op_node *op = node->data.op;
+    if (op->fuse == true) {
+        mark_chain(state, op->left, forked);
+        mark_chain(state, op->right, forked);
+    } else {
+        mark_node(state, op->left, false, false, forked);
+        mark_node(state, op->right, false, false, forked);
+    }
+}
+
+static void mark_written(escape_state *const state, ast_node *const node) {
+    // fused ops are streamed to the fd and a mixed vec literal is written item by item
+    if (fuse_is_vec_op(node) == true && node->data.op->fuse == true) {
+        mark_vec_op(state, node, AST_ALLOC_PFX(NONE), false);
+    } else if (node->type == AST_PFX(VEC) && node->data.vec->type->body.vec->dynamic == NULL) {
+        node->data.vec->alloc = AST_ALLOC_PFX(NONE);
+        for (ast_node_link *head = node->data.vec->items_head; head != NULL; head = head->next) {
+            if (head->node == NULL) continue;
+            if (fuse_is_vec_op(head->node) == true && head->node->data.op->fuse == true) mark_vec_op(state, head->node, AST_ALLOC_PFX(NONE), false);
+            else mark_node(state, head->node, false, false, false);
+        }
+    } else {
+        mark_node(state, node, false, false, false);
+    }
+}
+
+static void mark_node(escape_state *const state, ast_node *const node, bool escapes, bool dropped, bool forked) {
+    // escapes if the value outlives the frame, dropped if the value is never used
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            // vecs with more than one item type are never built
+            if (node->data.vec->type->body.vec->dynamic == NULL) node->data.vec->alloc = AST_ALLOC_PFX(NONE);
+            else if (dropped == true) set_alloc(state, &node->data.vec->alloc, AST_ALLOC_PFX(NONE));
+            else set_alloc(state, &node->data.vec->alloc, held_alloc(escapes, forked));
+            // items live as long as the vec
+            for (ast_node_link *head = node->data.vec->items_head; head != NULL; head = head->next) mark_node(state, head->node, escapes, dropped, forked);
+            break;
+        case AST_PFX(FN):
+            mark_fn(state, node->data.fn);
+            break;
+        case AST_PFX(CALL):
+            // args are held by the callee frame which is freed first
+            for (size_t i = 0; i < node->data.call->num_args; i++) mark_node(state, node->data.call->args[i], false, false, forked || node->data.call->fork);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(state, c->cond, false, false, forked);
+                mark_list(state, c->body_head, escapes, dropped, forked);
+            }
+            mark_list(state, node->data.ifn->else_head, escapes, dropped, forked);
+            break;
+        case AST_PFX(ASSIGN):
+            mark_node(state, node->data.op->left, false, false, forked);
+            mark_node(state, node->data.op->right, symbol_table_has_bucket(state->fn->type->body.fn->symbols, node->data.op->left->data.var) == false, false, forked);
+            break;
+        case AST_PFX(WRITE):
+            mark_node(state, node->data.op->left, false, false, forked);
+            mark_written(state, node->data.op->right);
+            break;
+        default:
+            if (fuse_is_vec_op(node) == true) {
+                mark_vec_op(state, node, held_alloc(escapes, forked), forked);
+            } else if (is_op(node) == true) {
+                // the left side of a fork runs on another thread, other operands are dropped after the op
+                mark_node(state, node->data.op->left, false, false, forked || node->data.op->fork);
+                mark_node(state, node->data.op->right, false, false, forked);
+            }
+            break;
+    }
+}
+
+void escape_mark(ast_fn_node *const root, escape_stats *const stats) {
+    mark_fn(&(escape_state) { .fn = root, .stats = stats }, root);
+}
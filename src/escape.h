@@ -0,0 +1,13 @@
+#pragma once
+
+#include "fuse.h"
+
+typedef struct {
+    size_t heap, frame, none; // vecs made at sites of each ast_alloc
+} escape_stats;
+
+// sets the alloc of vecs and vec ops, needs fork_mark and fuse_mark first
+// returned values, values assigned to vars of other fns and values made on another thread go on the heap
+// values only held by the frame that makes them go in its region
+// dropped vec literals, vecs only written and ops inside fused chains are never built
+void escape_mark(ast_fn_node *const root, escape_stats *const stats); // stats can be null
@@ -1,5 +1,10 @@
 
+#define _GNU_SOURCE
+
 #include "file.h"
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 
 extern inline int file_open_r(const char *const file_path);
 
@@ -20,3 +25,69 @@ string *file_read_to_string(int fd) {
     }
     return s;
 }
+
+bool file_write_iov(int fd, struct iovec *iov, int count) {
+    // writev can stop part way through an iov
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n <= 0) return false;
+        while (count > 0 && (size_t) n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+const char *file_map(int fd, size_t *const len) {
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || S_ISREG(sb.st_mode) == false || sb.st_size == 0) return NULL;
+    void *bytes = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (bytes == MAP_FAILED) return NULL;
+    madvise(bytes, sb.st_size, MADV_SEQUENTIAL);
+    *len = sb.st_size;
+    return bytes;
+}
+
+void file_unmap(const char *const bytes, size_t len) {
+    munmap((void*) bytes, len);
+}
+
+static bool transfer_rw(int out_fd, int in_fd) {
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(in_fd, buf, sizeof(buf))) > 0) {
+        struct iovec iov = { .iov_base = buf, .iov_len = n };
+        if (file_write_iov(out_fd, &iov, 1) == false) return false;
+    }
+    return n == 0;
+}
+
+bool file_transfer(int out_fd, int in_fd) {
+    // each way is tried in turn, an error before any bytes moved means the next one might work
+    struct stat in_sb, out_sb;
+    if (fstat(in_fd, &in_sb) == -1 || fstat(out_fd, &out_sb) == -1) return false;
+    ssize_t n = -1;
+    bool moved = false;
+    if (S_ISREG(in_sb.st_mode) && S_ISREG(out_sb.st_mode)) {
+        while ((n = copy_file_range(in_fd, NULL, out_fd, NULL, FILE_TRANSFER_CHUNK, 0)) > 0) moved = true;
+        if (n == 0) return true;
+        if (moved == true) return false;
+    }
+    if (S_ISREG(in_sb.st_mode)) {
+        while ((n = sendfile(out_fd, in_fd, NULL, FILE_TRANSFER_CHUNK)) > 0) moved = true;
+        if (n == 0) return true;
+        if (moved == true) return false;
+    }
+    if (S_ISFIFO(in_sb.st_mode) || S_ISFIFO(out_sb.st_mode)) {
+        while ((n = splice(in_fd, NULL, out_fd, NULL, FILE_TRANSFER_CHUNK, SPLICE_F_MOVE)) > 0) moved = true;
+        if (n == 0) return true;
+        if (moved == true) return false;
+    }
+    return transfer_rw(out_fd, in_fd);
+}
@@ -5,7 +5,11 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+#include <stddef.h>
 #include "string.h"
+#include "def.h"
 
 inline int file_open_r(const char *const file_path) {
     return open(file_path, O_RDONLY);
@@ -25,3 +29,11 @@ inline int file_close(int fd) {
 
 string *file_read_to_string(int fd);
 
+
+bool file_write_iov(int fd, struct iovec *iov, int count); // writes all of iov, iov is changed
+
+const char *file_map(int fd, size_t *const len); // read only view of a regular file, null if it cannot be mapped
+
+void file_unmap(const char *const bytes, size_t len);
+
+bool file_transfer(int out_fd, int in_fd); // copies to the end of in_fd inside the kernel when it can
@@ -0,0 +1,169 @@
+
+#include "fork.h"
+
+static void fork_fn_list_push(fork_fn_list **const list, ast_fn_node *const fn) {
+    if ((*list)->len >= (*list)->size) {
+        (*list)->size *= 2;
+        *list = realloc(*list, sizeof(fork_fn_list) + sizeof(ast_fn_node*) * (*list)->size);
+    }
+    (*list)->fns[(*list)->len++] = fn;
+}
+
+static void collect_fns(fork_fn_list **const list, ast_node *const node);
+
+static void collect_fns_list(fork_fn_list **const list, ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) collect_fns(list, head->node);
+}
+
+static void collect_fns(fork_fn_list **const list, ast_node *const node) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            collect_fns_list(list, node->data.vec->items_head);
+            break;
+        case AST_PFX(FN):
+            fork_fn_list_push(list, node->data.fn);
+            collect_fns_list(list, node->data.fn->body_head);
+            break;
+        case AST_PFX(CALL):
+            for (size_t i = 0; i < node->data.call->num_args; i++) collect_fns(list, node->data.call->args[i]);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                collect_fns(list, c->cond);
+                collect_fns_list(list, c->body_head);
+            }
+            collect_fns_list(list, node->data.ifn->else_head);
+            break;
+        default:
+            if (is_op(node)) {
+                collect_fns(list, node->data.op->left);
+                collect_fns(list, node->data.op->right);
+            }
+            break;
+    }
+}
+
+static bool node_pure(const ast_fn_node *const owner, const ast_node *const node);
+
+static bool node_list_pure(const ast_fn_node *const owner, ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL && node_pure(owner, head->node) == false) return false;
+    return true;
+}
+
+static bool node_pure(const ast_fn_node *const owner, const ast_node *const node) {
+    // owner is null when assigns are not allowed
+    if (node == NULL) return true;
+    switch (node->type) {
+        case AST_PFX(TYPE):
+        case AST_PFX(VAR):
+        case AST_PFX(INT):
+        case AST_PFX(FLOAT):
+        case AST_PFX(CHAR):
+        case AST_PFX(FN):
+            return true;
+        case AST_PFX(VEC):
+            return node_list_pure(owner, node->data.vec->items_head);
+        case AST_PFX(CALL):
+            if (node->data.call->func->type != AST_PFX(VAR)) return false;
+            if (node->data.call->func->data.var->type == NULL || node->data.call->func->data.var->type->header != VAR_PFX(FN)) return false;
+            if (node->data.call->func->data.var->type->body.fn->pure == false) return false;
+            for (size_t i = 0; i < node->data.call->num_args; i++) if (node_pure(owner, node->data.call->args[i]) == false) return false;
+            return true;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next)
+                if (node_pure(owner, c->cond) == false || node_list_pure(owner, c->body_head) == false) return false;
+            return node_list_pure(owner, node->data.ifn->else_head);
+        case AST_PFX(ASSIGN):
+            // only own locals, every call has its own frame
+            if (owner == NULL || node->data.op->left->type != AST_PFX(VAR)) return false;
+            if (symbol_table_has_bucket(owner->type->body.fn->symbols, node->data.op->left->data.var) == false) return false;
+            return node_pure(owner, node->data.op->right);
+        case AST_PFX(WRITE):
+            return false;
+        default:
+            if (is_op(node)) return node_pure(owner, node->data.op->left) && node_pure(owner, node->data.op->right);
+            break;
+    }
+    return false;
+}
+
+static bool node_has_call(const ast_node *const node) {
+    if (node == NULL) return false;
+    if (node->type == AST_PFX(CALL)) return true;
+    if (is_op(node)) return node_has_call(node->data.op->left) || node_has_call(node->data.op->right);
+    return false;
+}
+
+static bool node_forkable(const ast_node *const node) {
+    // siblings share the frame so no assigns at all
+    return node_has_call(node) && node_pure(NULL, node);
+}
+
+static void mark_node(ast_node *const node);
+
+static void mark_list(ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) mark_node(head->node);
+}
+
+static void mark_node(ast_node *const node) {
+    size_t forkable = 0;
+    bool all_pure = true;
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            mark_list(node->data.vec->items_head);
+            break;
+        case AST_PFX(FN):
+            mark_list(node->data.fn->body_head);
+            break;
+        case AST_PFX(CALL):
+            for (size_t i = 0; i < node->data.call->num_args; i++) {
+                mark_node(node->data.call->args[i]);
+                if (node_forkable(node->data.call->args[i])) forkable++;
+                else if (node_pure(NULL, node->data.call->args[i]) == false) all_pure = false;
+            }
+            node->data.call->fork = all_pure && forkable > 1;
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(c->cond);
+                mark_list(c->body_head);
+            }
+            mark_list(node->data.ifn->else_head);
+            break;
+        case AST_PFX(ADD):
+        case AST_PFX(SUB):
+            mark_node(node->data.op->left);
+            mark_node(node->data.op->right);
+            node->data.op->fork = node_forkable(node->data.op->left) && node_forkable(node->data.op->right);
+            break;
+        default:
+            if (is_op(node)) {
+                mark_node(node->data.op->left);
+                mark_node(node->data.op->right);
+            }
+            break;
+    }
+}
+
+void fork_mark(ast_fn_node *const root) {
+    fork_fn_list *list = calloc(1, sizeof(fork_fn_list) + sizeof(ast_fn_node*) * DEFAULT_SYMBOL_TABLE_SIZE);
+    list->size = DEFAULT_SYMBOL_TABLE_SIZE;
+    collect_fns_list(&list, root->body_head);
+    // assume pure then remove until nothing changes, recursive fns stay pure
+    for (size_t i = 0; i < list->len; i++) list->fns[i]->type->body.fn->pure = true;
+    bool changed = true;
+    while (changed == true) {
+        changed = false;
+        for (size_t i = 0; i < list->len; i++) {
+            ast_fn_node *fn = list->fns[i];
+            if (fn->type->body.fn->pure == true && node_list_pure(fn, fn->body_head) == false) {
+                fn->type->body.fn->pure = false;
+                changed = true;
+            }
+        }
+    }
+    free(list);
+    mark_list(root->body_head);
+}
@@ -0,0 +1,12 @@
+
+#pragma once
+
+#include "ast.h"
+
+typedef struct {
+    size_t size, len;
+    ast_fn_node *fns[];
+} fork_fn_list;
+
+// marks fns without side effects and the op and call nodes with independent pure calls
+void fork_mark(ast_fn_node *const root);
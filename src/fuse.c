@@ -0,0 +1,73 @@
+
+#include "fuse.h"
+
+bool fuse_is_vec_op(const ast_node *const node) {
+    switch (node->type) {
+        case AST_PFX(ADD):
+        case AST_PFX(SUB):
+        case AST_PFX(EQUAL):
+        case AST_PFX(LESSEQUAL):
+            return node->data.op->return_type != NULL && node->data.op->return_type->header == VAR_PFX(VEC);
+        default:
+            break;
+    }
+    return false;
+}
+
+static void mark_node(ast_node *const node, bool written);
+
+static void mark_chain(ast_node *const node) {
+    // ops inside a chain are run by the root, only the leaves are marked
+    if (fuse_is_vec_op(node)) {
+        mark_chain(node->data.op->left);
+        mark_chain(node->data.op->right);
+    } else {
+        mark_node(node, false);
+    }
+}
+
+static void mark_list(ast_node_link *head, bool written) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) mark_node(head->node, written);
+}
+
+static void mark_node(ast_node *const node, bool written) {
+    // written is true if the value of node only goes to a write
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            mark_list(node->data.vec->items_head, written);
+            break;
+        case AST_PFX(FN):
+            mark_list(node->data.fn->body_head, false);
+            break;
+        case AST_PFX(CALL):
+            for (size_t i = 0; i < node->data.call->num_args; i++) mark_node(node->data.call->args[i], false);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(c->cond, false);
+                mark_list(c->body_head, false);
+            }
+            mark_list(node->data.ifn->else_head, false);
+            break;
+        case AST_PFX(WRITE):
+            mark_node(node->data.op->left, false);
+            mark_node(node->data.op->right, true);
+            break;
+        default:
+            if (fuse_is_vec_op(node)) {
+                // the sides are part of this chain
+                node->data.op->fuse = written || fuse_is_vec_op(node->data.op->left) || fuse_is_vec_op(node->data.op->right);
+                mark_chain(node->data.op->left);
+                mark_chain(node->data.op->right);
+            } else if (is_op(node)) {
+                mark_node(node->data.op->left, false);
+                mark_node(node->data.op->right, false);
+            }
+            break;
+    }
+}
+
+void fuse_mark(ast_fn_node *const root) {
+    mark_list(root->body_head, false);
+}
@@ -0,0 +1,9 @@
+
+#pragma once
+
+#include "ast.h"
+
+bool fuse_is_vec_op(const ast_node *const node); // + - = <= with a vec return type
+
+// marks the roots of chains of vec ops and vec ops only consumed by a write
+void fuse_mark(ast_fn_node *const root);
@@ -0,0 +1,258 @@
+
+#include "hamt.h"
+
+extern inline hamt *hamt_copy(hamt *const h);
+
+static uint32_t bit_at(uint64_t key_hash, size_t shift) {
+    return (uint32_t) 1 << ((key_hash >> shift) & ((1 << HAMT_BITS) - 1));
+}
+
+static size_t data_idx(const hamt_node *const n, uint32_t bit) {
+    return __builtin_popcount(n->datamap & (bit - 1));
+}
+
+static size_t node_idx(const hamt_node *const n, uint32_t bit) {
+    return __builtin_popcount(n->datamap) + __builtin_popcount(n->nodemap & (bit - 1));
+}
+
+static hamt_leaf *leaf_init(uint64_t key_hash, const string *const key, var_value value) {
+    hamt_leaf *l = slab_alloc(sizeof(hamt_leaf));
+    memset(l, 0, sizeof(hamt_leaf));
+    atomic_init(&l->refs, 1);
+    l->hash = key_hash;
+    l->key = string_copy(key);
+    l->value = value;
+    return l;
+}
+
+static void leaf_retain(hamt_leaf *const l) {
+    if (l != NULL) atomic_fetch_add(&l->refs, 1);
+}
+
+static void leaf_release(hamt_leaf *l) {
+    while (l != NULL && atomic_fetch_sub(&l->refs, 1) == 1) {
+        hamt_leaf *next = l->next;
+        string_free(l->key);
+        slab_free(l, sizeof(hamt_leaf));
+        l = next;
+    }
+}
+
+static bool leaf_has_key(const hamt_leaf *const l, uint64_t key_hash, const string *const key) {
+    return l->hash == key_hash && l->key->len == key->len && memcmp(l->key->buffer, key->buffer, key->len) == 0;
+}
+
+static const hamt_leaf *chain_find(const hamt_leaf *l, uint64_t key_hash, const string *const key) {
+    while (l != NULL && leaf_has_key(l, key_hash, key) == false) l = l->next;
+    return l;
+}
+
+static hamt_leaf *chain_without(hamt_leaf *const l, uint64_t key_hash, const string *const key) {
+    // a new ref to the chain without key, leaves before it are copied
+    if (l == NULL) return NULL;
+    if (leaf_has_key(l, key_hash, key) == true) {
+        leaf_retain(l->next);
+        return l->next;
+    }
+    hamt_leaf *copy = leaf_init(l->hash, l->key, l->value);
+    copy->next = chain_without(l->next, key_hash, key);
+    return copy;
+}
+
+static size_t node_size(size_t num_slots) {
+    return sizeof(hamt_node) + sizeof(void*) * num_slots;
+}
+
+static hamt_node *node_init(uint32_t datamap, uint32_t nodemap) {
+    size_t size = __builtin_popcount(datamap) + __builtin_popcount(nodemap);
+    hamt_node *n = slab_alloc(node_size(size));
+    memset(n, 0, node_size(size));
+    atomic_init(&n->refs, 1);
+    n->datamap = datamap;
+    n->nodemap = nodemap;
+    return n;
+}
+
+static void node_release(hamt_node *const n) {
+    if (n == NULL || atomic_fetch_sub(&n->refs, 1) > 1) return;
+    size_t num_leaves = __builtin_popcount(n->datamap), size = num_leaves + __builtin_popcount(n->nodemap);
+    for (size_t i = 0; i < num_leaves; i++) leaf_release(n->slots[i]);
+    for (size_t i = num_leaves; i < size; i++) node_release(n->slots[i]);
+    slab_free(n, node_size(size));
+}
+
+static hamt_node *node_own(hamt_node *const n) {
+    // takes a ref to n and returns a node only the caller points to
+    if (atomic_load(&n->refs) == 1) return n;
+    size_t num_leaves = __builtin_popcount(n->datamap), size = num_leaves + __builtin_popcount(n->nodemap);
+    hamt_node *copy = node_init(n->datamap, n->nodemap);
+    memcpy(copy->slots, n->slots, sizeof(void*) * size);
+    for (size_t i = 0; i < num_leaves; i++) leaf_retain(copy->slots[i]);
+    for (size_t i = num_leaves; i < size; i++) atomic_fetch_add(&((hamt_node*) copy->slots[i])->refs, 1);
+    node_release(n);
+    return copy;
+}
+
+static hamt_node *node_rebuild(hamt_node *const n, uint32_t datamap, uint32_t nodemap, uint32_t bit, hamt_leaf *const leaf, hamt_node *const child) {
+    // takes a ref to n, the slot at bit is dropped and leaf or child is put in its place
+    bool unique = atomic_load(&n->refs) == 1;
+    hamt_node *ret = node_init(datamap, nodemap);
+    size_t i = 0;
+    for (uint32_t m = datamap; m != 0; m &= m - 1) {
+        uint32_t b = m & -m;
+        hamt_leaf *l = b == bit ? leaf : n->slots[data_idx(n, b)];
+        if (b != bit && unique == false) leaf_retain(l);
+        ret->slots[i++] = l;
+    }
+    for (uint32_t m = nodemap; m != 0; m &= m - 1) {
+        uint32_t b = m & -m;
+        hamt_node *c = b == bit ? child : n->slots[node_idx(n, b)];
+        if (b != bit && unique == false) atomic_fetch_add(&c->refs, 1);
+        ret->slots[i++] = c;
+    }
+    if (unique == false) {
+        node_release(n);
+        return ret;
+    }
+    if (n->datamap & bit) leaf_release(n->slots[data_idx(n, bit)]);
+    if (n->nodemap & bit) node_release(n->slots[node_idx(n, bit)]);
+    slab_free(n, node_size(__builtin_popcount(n->datamap) + __builtin_popcount(n->nodemap)));
+    return ret;
+}
+
+static hamt_node *node_pair(hamt_leaf *const a, hamt_leaf *const b, size_t shift) {
+    // the hashes differ so the leaves split before the bits run out
+    uint32_t a_bit = bit_at(a->hash, shift), b_bit = bit_at(b->hash, shift);
+    if (a_bit == b_bit) {
+        hamt_node *n = node_init(0, a_bit);
+        n->slots[0] = node_pair(a, b, shift + HAMT_BITS);
+        return n;
+    }
+    hamt_node *n = node_init(a_bit | b_bit, 0);
+    n->slots[0] = a_bit < b_bit ? a : b;
+    n->slots[1] = a_bit < b_bit ? b : a;
+    return n;
+}
+
+static hamt_node *node_set(hamt_node *n, size_t shift, hamt_leaf *const leaf, bool *const added) {
+    // takes the refs to n and leaf
+    uint32_t bit = bit_at(leaf->hash, shift);
+    if (n->datamap & bit) {
+        hamt_leaf *old = n->slots[data_idx(n, bit)];
+        if (old->hash != leaf->hash) {
+            leaf_retain(old);
+            *added = true;
+            return node_rebuild(n, n->datamap & ~bit, n->nodemap | bit, bit, NULL, node_pair(old, leaf, shift + HAMT_BITS));
+        }
+        // the same full hash is chained
+        *added = chain_find(old, leaf->hash, leaf->key) == NULL;
+        if (*added == true) {
+            leaf_retain(old);
+            leaf->next = old;
+        } else {
+            leaf->next = chain_without(old, leaf->hash, leaf->key);
+        }
+        n = node_own(n);
+        leaf_release(n->slots[data_idx(n, bit)]);
+        n->slots[data_idx(n, bit)] = leaf;
+        return n;
+    }
+    if (n->nodemap & bit) {
+        n = node_own(n);
+        size_t idx = node_idx(n, bit);
+        n->slots[idx] = node_set(n->slots[idx], shift + HAMT_BITS, leaf, added);
+        return n;
+    }
+    *added = true;
+    return node_rebuild(n, n->datamap | bit, n->nodemap, bit, leaf, NULL);
+}
+
+static hamt_node *node_remove(hamt_node *n, size_t shift, uint64_t key_hash, const string *const key) {
+    // takes the ref to n, key must be in n
+    uint32_t bit = bit_at(key_hash, shift);
+    if (n->datamap & bit) {
+        hamt_leaf *rest = chain_without(n->slots[data_idx(n, bit)], key_hash, key);
+        if (rest == NULL) return node_rebuild(n, n->datamap & ~bit, n->nodemap, bit, NULL, NULL);
+        n = node_own(n);
+        leaf_release(n->slots[data_idx(n, bit)]);
+        n->slots[data_idx(n, bit)] = rest;
+        return n;
+    }
+    n = node_own(n);
+    size_t idx = node_idx(n, bit);
+    hamt_node *child = node_remove(n->slots[idx], shift + HAMT_BITS, key_hash, key);
+    n->slots[idx] = child;
+    if (child->nodemap == 0 && __builtin_popcount(child->datamap) == 1) {
+        // a lone leaf moves up so the trie stays as shallow as it can be
+        leaf_retain(child->slots[0]);
+        return node_rebuild(n, n->datamap | bit, n->nodemap & ~bit, bit, child->slots[0], NULL);
+    }
+    return n;
+}
+
+hamt *hamt_init(void) {
+    hamt *h = slab_alloc(sizeof(hamt));
+    memset(h, 0, sizeof(hamt));
+    atomic_init(&h->refs, 1);
+    h->root = node_init(0, 0);
+    return h;
+}
+
+void hamt_free(hamt *h) {
+    if (atomic_fetch_sub(&h->refs, 1) > 1) return;
+    node_release(h->root);
+    slab_free(h, sizeof(hamt));
+}
+
+hash_status hamt_get(const hamt *const h, const string *const key, var_value *const value) {
+    uint64_t key_hash = hash_key(key->buffer, key->len);
+    const hamt_node *n = h->root;
+    for (size_t shift = 0;; shift += HAMT_BITS) {
+        uint32_t bit = bit_at(key_hash, shift);
+        if (n->datamap & bit) {
+            const hamt_leaf *l = chain_find(n->slots[data_idx(n, bit)], key_hash, key);
+            if (l == NULL) break;
+            *value = l->value;
+            return HASH_STATUS_PFX(OK);
+        }
+        if ((n->nodemap & bit) == 0) break;
+        n = n->slots[node_idx(n, bit)];
+    }
+    return HASH_STATUS_PFX(KEY_NOT_FOUND);
+}
+
+hamt *hamt_transient(hamt *const h) {
+    hamt *t = slab_alloc(sizeof(hamt));
+    memset(t, 0, sizeof(hamt));
+    atomic_init(&t->refs, 1);
+    t->len = h->len;
+    t->root = h->root;
+    atomic_fetch_add(&t->root->refs, 1);
+    return t;
+}
+
+void hamt_set_in_place(hamt *const t, const string *const key, var_value value) {
+    bool added = false;
+    t->root = node_set(t->root, 0, leaf_init(hash_key(key->buffer, key->len), key, value), &added);
+    if (added == true) t->len++;
+}
+
+hash_status hamt_remove_in_place(hamt *const t, const string *const key) {
+    var_value value;
+    if (hamt_get(t, key, &value) != HASH_STATUS_PFX(OK)) return HASH_STATUS_PFX(KEY_NOT_FOUND);
+    t->root = node_remove(t->root, 0, hash_key(key->buffer, key->len), key);
+    t->len--;
+    return HASH_STATUS_PFX(OK);
+}
+
+hamt *hamt_set(hamt *const h, const string *const key, var_value value) {
+    hamt *t = hamt_transient(h);
+    hamt_set_in_place(t, key, value);
+    return t;
+}
+
+hamt *hamt_remove(hamt *const h, const string *const key) {
+    hamt *t = hamt_transient(h);
+    hamt_remove_in_place(t, key);
+    return t;
+}
@@ -0,0 +1,54 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "hash.h"
+
+#define HAMT_BITS 5 // a bit for each slot fits in a uint32_t
+
+typedef struct _hamt_leaf {
+    atomic_size_t refs;
+    uint64_t hash;
+    string *key;
+    var_value value;
+    struct _hamt_leaf *next; // leaves with the same full hash
+} hamt_leaf;
+
+typedef struct _hamt_node {
+    atomic_size_t refs;
+    uint32_t datamap, nodemap; // a bit for each HAMT_BITS of the hash, leaves are before nodes in slots
+    void *slots[];
+} hamt_node;
+
+typedef struct {
+    atomic_size_t refs;
+    size_t len;
+    hamt_node *root;
+} hamt;
+
+hamt *hamt_init(void);
+
+inline hamt *hamt_copy(hamt *const h) {
+    atomic_fetch_add(&h->refs, 1);
+    return h;
+}
+
+void hamt_free(hamt *h);
+
+hash_status hamt_get(const hamt *const h, const string *const key, var_value *const value);
+
+// a new version that shares the trie with h, nodes are copied the first time they are changed
+hamt *hamt_transient(hamt *const h);
+
+// change t in place, t must not be shared
+void hamt_set_in_place(hamt *const t, const string *const key, var_value value);
+
+hash_status hamt_remove_in_place(hamt *const t, const string *const key);
+
+// h is unchanged, the new version shares all but the changed path
+hamt *hamt_set(hamt *const h, const string *const key, var_value value);
+
+hamt *hamt_remove(hamt *const h, const string *const key);
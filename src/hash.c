@@ -1,4 +1,263 @@
 
 #include "hash.h"
 
-extern inline hash *hash_init(size_t size);
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    _Static_assert(HASH_GROUP_SIZE == 16, "sse2 groups are 16 bytes");
+#endif
+
+extern inline const char *hash_node_key(const hash_node *const n);
+
+static uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+uint64_t hash_key(const char *const key, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15 ^ len, word;
+    size_t i = 0;
+    for (; i + sizeof(word) <= len; i += sizeof(word)) {
+        memcpy(&word, key + i, sizeof(word));
+        h = mix(h ^ word);
+    }
+    word = 0;
+    memcpy(&word, key + i, len - i);
+    return mix(h ^ word);
+}
+
+static uint32_t group_match(const uint8_t *const ctrl, uint8_t byte) {
+    // bit i is set if ctrl[i] is byte
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i*) ctrl);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) byte)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < HASH_GROUP_SIZE; i++) mask |= (uint32_t) (ctrl[i] == byte) << i;
+    return mask;
+#endif
+}
+
+static size_t hash_home(const hash *const h, uint64_t key_hash) {
+    return (key_hash >> 7) & (h->size - 1);
+}
+
+static void set_ctrl(hash *const h, size_t idx, uint8_t byte) {
+    h->ctrl[idx] = byte;
+    if (idx < HASH_GROUP_SIZE) h->ctrl[h->size + idx] = byte;
+}
+
+static void hash_alloc(hash *const h, size_t size) {
+    h->size = size;
+    h->used = 0;
+    h->ctrl = slab_alloc(size + HASH_GROUP_SIZE);
+    memset(h->ctrl, HASH_CTRL_EMPTY, size + HASH_GROUP_SIZE);
+    h->nodes = slab_alloc(size * sizeof(hash_node));
+    memset(h->nodes, 0, size * sizeof(hash_node));
+}
+
+hash *hash_init(size_t size) {
+    // room for size keys under the max load
+    size_t want = size * 100 / HASH_MAX_LOAD_PERCENT + 1, pow2 = HASH_GROUP_SIZE;
+    while (pow2 < want) pow2 *= 2;
+    hash *h = slab_alloc(sizeof(hash));
+    memset(h, 0, sizeof(hash));
+    hash_alloc(h, pow2);
+    return h;
+}
+
+void hash_free(hash *h) {
+    for (size_t i = 0; i < h->size; i++)
+        if (h->ctrl[i] != HASH_CTRL_EMPTY && h->nodes[i].len > HASH_INLINE_KEY) string_free(h->nodes[i].key);
+    slab_free(h->ctrl, h->size + HASH_GROUP_SIZE);
+    slab_free(h->nodes, h->size * sizeof(hash_node));
+    slab_free(h, sizeof(hash));
+}
+
+static size_t find_empty(const hash *const h, uint64_t key_hash) {
+    // the load limit makes sure there is one
+    size_t pos = hash_home(h, key_hash), mask;
+    while ((mask = group_match(h->ctrl + pos, HASH_CTRL_EMPTY)) == 0) pos = (pos + HASH_GROUP_SIZE) & (h->size - 1);
+    return (pos + __builtin_ctz(mask)) & (h->size - 1);
+}
+
+static bool find_key(const hash *const h, const string *const key, uint64_t key_hash, size_t *const idx) {
+    // probes group by group from home, there are no gaps between a key and its home
+    size_t pos = hash_home(h, key_hash);
+    for (size_t probes = 0; probes <= h->size / HASH_GROUP_SIZE; probes++) {
+        for (uint32_t mask = group_match(h->ctrl + pos, key_hash & 0x7F); mask != 0; mask &= mask - 1) {
+            size_t i = (pos + __builtin_ctz(mask)) & (h->size - 1);
+            const hash_node *n = &h->nodes[i];
+            if (n->hash == key_hash && n->len == key->len && memcmp(hash_node_key(n), key->buffer, key->len) == 0) {
+                *idx = i;
+                return true;
+            }
+        }
+        if (group_match(h->ctrl + pos, HASH_CTRL_EMPTY) != 0) break;
+        pos = (pos + HASH_GROUP_SIZE) & (h->size - 1);
+    }
+    return false;
+}
+
+static void grow(hash *const h) {
+    // hashes are kept so nodes are moved without touching the keys
+    uint8_t *ctrl = h->ctrl;
+    hash_node *nodes = h->nodes;
+    size_t size = h->size, used = h->used;
+    hash_alloc(h, size * REHASH_SIZE_MULTIPLIER);
+    for (size_t i = 0; i < size; i++) {
+        if (ctrl[i] == HASH_CTRL_EMPTY) continue;
+        size_t idx = find_empty(h, nodes[i].hash);
+        h->nodes[idx] = nodes[i];
+        set_ctrl(h, idx, ctrl[i]);
+    }
+    h->used = used;
+    slab_free(ctrl, size + HASH_GROUP_SIZE);
+    slab_free(nodes, size * sizeof(hash_node));
+}
+
+hash_status hash_get(const hash *const h, const string *const key, var_value *const value) {
+    size_t idx;
+    if (find_key(h, key, hash_key(key->buffer, key->len), &idx) == false) return HASH_STATUS_PFX(KEY_NOT_FOUND);
+    *value = h->nodes[idx].value;
+    return HASH_STATUS_PFX(OK);
+}
+
+void hash_set(hash *const h, const string *const key, var_value value) {
+    uint64_t key_hash = hash_key(key->buffer, key->len);
+    size_t idx;
+    if (find_key(h, key, key_hash, &idx) == true) {
+        h->nodes[idx].value = value;
+        return;
+    }
+    if ((h->used + 1) * 100 > h->size * HASH_MAX_LOAD_PERCENT) grow(h);
+    idx = find_empty(h, key_hash);
+    hash_node *n = &h->nodes[idx];
+    n->hash = key_hash;
+    n->value = value;
+    n->len = key->len;
+    if (key->len <= HASH_INLINE_KEY) memcpy(n->small, key->buffer, key->len);
+    else n->key = string_copy(key);
+    set_ctrl(h, idx, key_hash & 0x7F);
+    h->used++;
+}
+
+hash_status hash_remove(hash *const h, const string *const key, var_value *const value) {
+    size_t idx, mask = h->size - 1;
+    if (find_key(h, key, hash_key(key->buffer, key->len), &idx) == false) return HASH_STATUS_PFX(KEY_NOT_FOUND);
+    if (value != NULL) *value = h->nodes[idx].value;
+    if (h->nodes[idx].len > HASH_INLINE_KEY) string_free(h->nodes[idx].key);
+    // shift later nodes back into the gap so no tombstone is left
+    for (size_t next = (idx + 1) & mask; h->ctrl[next] != HASH_CTRL_EMPTY; next = (next + 1) & mask) {
+        size_t home = hash_home(h, h->nodes[next].hash);
+        if (((next - home) & mask) < ((next - idx) & mask)) continue;
+        h->nodes[idx] = h->nodes[next];
+        set_ctrl(h, idx, h->ctrl[next]);
+        idx = next;
+    }
+    set_ctrl(h, idx, HASH_CTRL_EMPTY);
+    h->used--;
+    return HASH_STATUS_PFX(OK);
+}
+
+static size_t perfect_slot(uint64_t key_hash, uint32_t seed, size_t num_slots) {
+    return mix(key_hash ^ (seed * 0x9E3779B97F4A7C15)) % num_slots;
+}
+
+typedef struct {
+    uint64_t hash;
+    size_t bucket;
+    const symbol_table_bucket *key;
+} perfect_key;
+
+static int perfect_key_cmp(const void *a, const void *b) {
+    // keys of a bucket next to each other
+    const perfect_key *left = a, *right = b;
+    if (left->bucket != right->bucket) return left->bucket < right->bucket ? -1 : 1;
+    return 0;
+}
+
+static bool perfect_place(hash_perfect *const p, perfect_key *const keys, size_t num_keys, size_t *const bucket_sizes) {
+    size_t *order = calloc(p->num_buckets, sizeof(size_t)), *starts = calloc(p->num_buckets, sizeof(size_t)), *slots = calloc(num_keys, sizeof(size_t));
+    for (size_t i = 0, start = 0; i < p->num_buckets; start += bucket_sizes[i++]) {
+        order[i] = i;
+        starts[i] = start;
+    }
+    // insertion sort by size, there are few buckets
+    for (size_t i = 1; i < p->num_buckets; i++)
+        for (size_t j = i; j > 0 && bucket_sizes[order[j]] > bucket_sizes[order[j - 1]]; j--) {
+            size_t tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    bool ok = true;
+    for (size_t i = 0; i < p->num_buckets && ok == true && bucket_sizes[order[i]] > 0; i++) {
+        size_t b = order[i], len = bucket_sizes[b];
+        perfect_key *bucket = keys + starts[b];
+        ok = false;
+        for (uint32_t seed = 0; seed < HASH_PERFECT_MAX_SEED && ok == false; seed++) {
+            size_t placed = 0;
+            for (; placed < len; placed++) {
+                slots[placed] = perfect_slot(bucket[placed].hash, seed, p->num_slots);
+                if (p->slots[slots[placed]] != NULL) break;
+                p->slots[slots[placed]] = bucket[placed].key;
+            }
+            if (placed == len) {
+                p->seeds[b] = seed;
+                ok = true;
+            } else {
+                while (placed-- > 0) p->slots[slots[placed]] = NULL;
+            }
+        }
+    }
+    free(order);
+    free(starts);
+    free(slots);
+    return ok;
+}
+
+hash_perfect *hash_perfect_init(const symbol_table *const keys) {
+    size_t num_keys = keys->symbol_counter, k = 0;
+    hash_perfect *p = calloc(1, sizeof(hash_perfect));
+    p->num_buckets = num_keys / HASH_PERFECT_BUCKET_KEYS + 1;
+    p->num_slots = num_keys > 0 ? num_keys : 1;
+    p->seeds = calloc(p->num_buckets, sizeof(uint32_t));
+    perfect_key *pkeys = calloc(num_keys > 0 ? num_keys : 1, sizeof(perfect_key));
+    size_t *bucket_sizes = calloc(p->num_buckets, sizeof(size_t));
+    for (size_t i = 0; i < keys->size; i++) {
+        for (const symbol_table_bucket *b = keys->buckets[i]; b != NULL; b = b->next, k++) {
+            pkeys[k].hash = hash_key(b->symbol, b->size_len - 1);
+            pkeys[k].bucket = pkeys[k].hash % p->num_buckets;
+            pkeys[k].key = b;
+            bucket_sizes[pkeys[k].bucket]++;
+        }
+    }
+    qsort(pkeys, num_keys, sizeof(perfect_key), perfect_key_cmp);
+    // minimal if it can be, otherwise a slot more until every bucket finds a seed
+    for (;;) {
+        p->slots = calloc(p->num_slots, sizeof(symbol_table_bucket*));
+        if (perfect_place(p, pkeys, num_keys, bucket_sizes) == true) break;
+        free(p->slots);
+        p->num_slots++;
+    }
+    free(pkeys);
+    free(bucket_sizes);
+    return p;
+}
+
+void hash_perfect_free(hash_perfect *p) {
+    free(p->seeds);
+    free(p->slots);
+    free(p);
+}
+
+hash_status hash_perfect_find(const hash_perfect *const p, const string *const key, size_t *const key_idx) {
+    uint64_t key_hash = hash_key(key->buffer, key->len);
+    const symbol_table_bucket *b = p->slots[perfect_slot(key_hash, p->seeds[key_hash % p->num_buckets], p->num_slots)];
+    if (b == NULL || b->size_len - 1 != key->len || memcmp(b->symbol, key->buffer, key->len) != 0) return HASH_STATUS_PFX(KEY_NOT_IN_FIXED);
+    *key_idx = b->idx.key;
+    return HASH_STATUS_PFX(OK);
+}
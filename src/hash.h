@@ -3,31 +3,64 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "string.h"
 #include "def.h"
+#include "slab.h"
 #include "type.h"
 
-typedef struct _var var;
+typedef uint64_t var_value; // tagged value from var.h
+
+#define HASH_CTRL_EMPTY 0x80 // full slots hold the low 7 bits of the key hash
 
 typedef struct {
-    string *key;
-    var *value;
+    uint64_t hash; // checked before the key, growing does not rehash keys
+    var_value value;
+    size_t len;
+    union {
+        char small[HASH_INLINE_KEY]; // keys up to HASH_INLINE_KEY bytes are kept in the node
+        string *key;
+    };
 } hash_node;
 
 typedef struct {
-    size_t size, used;
-    hash_node buckets[]; // rehash on collision fixed keys are accesses by idx
+    size_t size, used; // size is a power of 2 and at least HASH_GROUP_SIZE
+    uint8_t *ctrl; // a byte per node then the first group again so a group can be read past the end
+    hash_node *nodes;
 } hash;
 
 #define HASH_STATUS_PFX(NAME) HASH_STATUS_##NAME
 
 typedef enum {
     HASH_STATUS_PFX(OK),
+    HASH_STATUS_PFX(KEY_NOT_FOUND),
     HASH_STATUS_PFX(KEY_NOT_IN_FIXED)
 } hash_status;
 
-inline hash *hash_init(size_t size) {
-    hash *h = calloc(1, sizeof(hash) + sizeof(hash_node) * size);
-    h->size = size;
-    return h;
+uint64_t hash_key(const char *const key, size_t len);
+
+hash *hash_init(size_t size);
+
+void hash_free(hash *h); // values are not owned
+
+inline const char *hash_node_key(const hash_node *const n) {
+    return n->len <= HASH_INLINE_KEY ? n->small : n->key->buffer;
 }
+
+hash_status hash_get(const hash *const h, const string *const key, var_value *const value);
+
+void hash_set(hash *const h, const string *const key, var_value value); // inserts or replaces
+
+hash_status hash_remove(hash *const h, const string *const key, var_value *const value);
+
+typedef struct _hash_perfect {
+    size_t num_buckets, num_slots;
+    uint32_t *seeds; // one per bucket, picked so every key gets its own slot
+    const symbol_table_bucket **slots; // null if no key
+} hash_perfect;
+
+hash_perfect *hash_perfect_init(const symbol_table *const keys); // keys must outlive it
+
+void hash_perfect_free(hash_perfect *p);
+
+hash_status hash_perfect_find(const hash_perfect *const p, const string *const key, size_t *const key_idx);
@@ -37,6 +37,8 @@ const char *infer_status_string(infer_status status) {
         "INVALID_RIGHT_SIDE",
         "NODE_TYPES_NOT_EQUAL",
         "INVALID_TYPE_FOR_NODE",
+        "VEC_NOT_HOMOGENEOUS",
+        "INT_OUT_OF_RANGE",
         "_END_INFER"
     };
     return status > INFER_STATUS_PFX(_START_INFER) && status < INFER_STATUS_PFX(_END_INFER) ? statuses[status]: "INFER_STATUS_NOT_FOUND";
@@ -44,7 +46,7 @@ const char *infer_status_string(infer_status status) {
 
 extern inline infer_status infer_error(infer_state *const state, infer_status status, ast_node *const node);
 
-static bool get_type_from_node(const ast_node *const node, var_type *const type) {
+bool get_type_from_node(const ast_node *const node, var_type *const type) {
     var_type inner_type;
     if (node == NULL) return false;
     switch (node->type) {
@@ -58,6 +60,9 @@ static bool get_type_from_node(const ast_node *const node, var_type *const type)
         case AST_PFX(INT):
             type->header = VAR_PFX(I64);
             return true;
+        case AST_PFX(FLOAT):
+            type->header = VAR_PFX(F64);
+            return true;
         case AST_PFX(CHAR):
             type->header = VAR_PFX(CHAR);
             return true;
@@ -149,18 +154,22 @@ static infer_status infer_op_node_sides(infer_state *const state, ast_fn_node *c
     return INFER_STATUS_PFX(OK);
 }
 
-static infer_status infer_node_with_equal_type_sides(infer_state *const state, ast_fn_node *const cur_fn, ast_node *const node) {
-    infer_status is;
-    if ((is = infer_op_node_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK)) return is;
-    // check types are equal
+static bool cast_wide_int(const ast_node *const node) {
+    // the parsed bits of an int literal are already the u64 value
+    const ast_node *left = node->data.op->left, *right = node->data.op->right;
+    return left != NULL && right != NULL && left->type == AST_PFX(TYPE) && left->data.type->header == VAR_PFX(U64) && right->type == AST_PFX(INT);
+}
+
+static infer_status check_equal_type_sides(const ast_node *const node) {
+    // sides must already be inferred
     if (node_equal_types(node->data.op->left, node->data.op->right) == false)
         return INFER_STATUS_PFX(NODE_TYPES_NOT_EQUAL);
     return INFER_STATUS_PFX(OK);
 }
 
-static infer_status infer_node_with_equal_type_sides_and_return(infer_state *const state, ast_fn_node *const cur_fn, ast_node *const node, bool (*type_check)(var_type_header)) {
+static infer_status infer_equal_type_sides_and_return(infer_state *const state, ast_node *const node, bool (*type_check)(var_type_header)) {
     infer_status is;
-    if ((is = infer_node_with_equal_type_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
+    if ((is = check_equal_type_sides(node)) != INFER_STATUS_PFX(OK))
         return infer_error(state, is, node);
     // set the type of the node
     node->data.op->return_type = var_type_init_from_node(node->data.op->left);
@@ -170,10 +179,34 @@ static infer_status infer_node_with_equal_type_sides_and_return(infer_state *con
     return INFER_STATUS_PFX(OK);
 }
 
+static bool node_has_vec_side(const ast_node *const node) {
+    var_type left, right;
+    if (get_type_from_node(node->data.op->left, &left) == true && left.header == VAR_PFX(VEC)) return true;
+    return get_type_from_node(node->data.op->right, &right) == true && right.header == VAR_PFX(VEC);
+}
+
 static bool var_type_number_cmp(var_type_header header) {
     return var_type_is_unsgined(header) || var_type_is_signed(header) || var_type_is_float(header);
 }
 
+static infer_status infer_vec_op(infer_state *const state, ast_node *const node, bool cmp) {
+    // both vecs with the same item type or a vec and a scalar of its item type
+    var_type left, right;
+    if (get_type_from_node(node->data.op->left, &left) == false || get_type_from_node(node->data.op->right, &right) == false)
+        return infer_error(state, INFER_STATUS_PFX(CANNOT_GET_TYPE_FROM_NODE), node);
+    var_type *item = left.header == VAR_PFX(VEC) ? left.body.vec->dynamic : right.body.vec->dynamic;
+    if (item == NULL || var_type_number_cmp(item->header) == false)
+        return infer_error(state, INFER_STATUS_PFX(VEC_NOT_HOMOGENEOUS), node);
+    if (left.header == VAR_PFX(VEC) && right.header == VAR_PFX(VEC)) {
+        if (var_type_equal(&left, &right) == false) return infer_error(state, INFER_STATUS_PFX(NODE_TYPES_NOT_EQUAL), node);
+    } else if (var_type_equal(item, left.header == VAR_PFX(VEC) ? &right : &left) == false) {
+        return infer_error(state, INFER_STATUS_PFX(NODE_TYPES_NOT_EQUAL), node);
+    }
+    node->data.op->return_type = var_type_vec_init(0);
+    node->data.op->return_type->body.vec->dynamic = var_type_init(cmp ? VAR_PFX(U8) : item->header, true, (var_type_body) {});
+    return INFER_STATUS_PFX(OK);
+}
+
 static bool var_type_not_void(var_type_header header) {
     return header != VAR_PFX(VOID);
 }
@@ -198,6 +231,10 @@ infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast
             if (node->data.var->type == NULL) return infer_error(state, INFER_STATUS_PFX(VAR_TYPE_NOT_FOUND), node);
             return INFER_STATUS_PFX(OK);
         case AST_PFX(INT):
+            // literals past i64 only fit a cast to u64
+            if (node->data.intv < 0) return infer_error(state, INFER_STATUS_PFX(INT_OUT_OF_RANGE), node);
+            return INFER_STATUS_PFX(OK);
+        case AST_PFX(FLOAT):
         case AST_PFX(CHAR):
             return INFER_STATUS_PFX(OK);
         case AST_PFX(VEC):
@@ -217,6 +254,11 @@ infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast
                     }
                     head = head->next;
                 }
+                // items of one number type are packed at run time
+                bool homogeneous = var_type_number_cmp(node->data.vec->type->body.vec->items[0]->header);
+                for (size_t i = 1; i < len_counter && homogeneous == true; i++)
+                    homogeneous = var_type_equal(node->data.vec->type->body.vec->items[0], node->data.vec->type->body.vec->items[i]);
+                if (homogeneous == true) node->data.vec->type->body.vec->dynamic = var_type_init_copy(node->data.vec->type->body.vec->items[0]);
             } else {
                 // TODO dynamic size fixed type
             }
@@ -294,8 +336,9 @@ infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast
             node->data.op->return_type = var_type_init(VAR_PFX(VOID), true, (var_type_body) {});
             return INFER_STATUS_PFX(OK);
         case AST_PFX(CAST):
-            if ((is = infer_op_node_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
-                return infer_error(state, is, node);
+            if (cast_wide_int(node) == true) is = infer_node(state, cur_fn, node->data.op->left);
+            else is = infer_op_node_sides(state, cur_fn, node);
+            if (is != INFER_STATUS_PFX(OK)) return infer_error(state, is, node);
             // left must be node type or var with type
             if (node->data.op->left->type != AST_PFX(TYPE) && node->data.op->left->type != AST_PFX(VAR))
                 return infer_error(state, INFER_STATUS_PFX(INVALID_CAST_LEFT_NODE), node->data.op->left);
@@ -310,7 +353,10 @@ infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast
             return INFER_STATUS_PFX(OK);
         case AST_PFX(ADD):
         case AST_PFX(SUB):
-            return infer_node_with_equal_type_sides_and_return(state, cur_fn, node, var_type_number_cmp);
+            if ((is = infer_op_node_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
+                return infer_error(state, is, node);
+            if (node_has_vec_side(node) == true) return infer_vec_op(state, node, false);
+            return infer_equal_type_sides_and_return(state, node, var_type_number_cmp);
         case AST_PFX(WRITE):
             if ((is = infer_op_node_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
                 return infer_error(state, is, node);
@@ -329,7 +375,10 @@ infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast
             return INFER_STATUS_PFX(OK);
         case AST_PFX(EQUAL):
         case AST_PFX(LESSEQUAL):
-            if ((is = infer_node_with_equal_type_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
+            if ((is = infer_op_node_sides(state, cur_fn, node)) != INFER_STATUS_PFX(OK))
+                return infer_error(state, is, node);
+            if (node_has_vec_side(node) == true) return infer_vec_op(state, node, true);
+            if ((is = check_equal_type_sides(node)) != INFER_STATUS_PFX(OK))
                 return infer_error(state, is, node);
             node->data.op->return_type = var_type_init(VAR_PFX(U8), true, (var_type_body) {});
             return INFER_STATUS_PFX(OK);
@@ -55,6 +55,8 @@ typedef enum {
     INFER_STATUS_PFX(INVALID_RIGHT_SIDE),
     INFER_STATUS_PFX(NODE_TYPES_NOT_EQUAL),
     INFER_STATUS_PFX(INVALID_TYPE_FOR_NODE),
+    INFER_STATUS_PFX(VEC_NOT_HOMOGENEOUS),
+    INFER_STATUS_PFX(INT_OUT_OF_RANGE),
     INFER_STATUS_PFX(_END_INFER)
 } infer_status;
 
@@ -65,6 +67,8 @@ inline infer_status infer_error(infer_state *const state, infer_status status, a
     return status;
 }
 
+bool get_type_from_node(const ast_node *const node, var_type *const type);
+
 infer_status infer_node(infer_state *const state, ast_fn_node *const cur_fn, ast_node *const node);
 
 infer_status infer(infer_state *const state);
@@ -1,2 +1,130 @@
-
 #include "ir.h"
+
+static void mark_node(const symbol_table *const symbols, bool *const marks, bool assigns, const ast_node *const node);
+
+static void mark_list(const symbol_table *const symbols, bool *const marks, bool assigns, const ast_node_link *head, const ast_node_link *const end) {
+    for (; head != end; head = head->next) if (head->node != NULL) mark_node(symbols, marks, assigns, head->node);
+}
+
+static void mark_node(const symbol_table *const symbols, bool *const marks, bool assigns, const ast_node *const node) {
+    // marks the locals of symbols read or assigned by node, nested fns reach them through the frame
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VAR):
+            if (assigns == false && symbol_table_has_bucket(symbols, node->data.var)) marks[node->data.var->idx.stack] = true;
+            break;
+        case AST_PFX(VEC):
+            mark_list(symbols, marks, assigns, node->data.vec->items_head, NULL);
+            break;
+        case AST_PFX(FN):
+            mark_list(symbols, marks, assigns, node->data.fn->body_head, NULL);
+            break;
+        case AST_PFX(CALL):
+            mark_node(symbols, marks, assigns, node->data.call->func);
+            for (size_t i = 0; i < node->data.call->num_args; i++) mark_node(symbols, marks, assigns, node->data.call->args[i]);
+            break;
+        case AST_PFX(IF):
+            for (const ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(symbols, marks, assigns, c->cond);
+                mark_list(symbols, marks, assigns, c->body_head, NULL);
+            }
+            mark_list(symbols, marks, assigns, node->data.ifn->else_head, NULL);
+            break;
+        case AST_PFX(ASSIGN):
+            if (node->data.op->left->type == AST_PFX(VAR)) {
+                if (assigns == true && symbol_table_has_bucket(symbols, node->data.op->left->data.var)) marks[node->data.op->left->data.var->idx.stack] = true;
+            } else {
+                mark_node(symbols, marks, assigns, node->data.op->left);
+            }
+            mark_node(symbols, marks, assigns, node->data.op->right);
+            break;
+        default:
+            if (is_op(node)) {
+                mark_node(symbols, marks, assigns, node->data.op->left);
+                mark_node(symbols, marks, assigns, node->data.op->right);
+            }
+            break;
+    }
+}
+
+bool ir_fn_suspends(const ast_fn_node *const fn) {
+    for (const ast_node_link *head = fn->body_head; head != NULL; head = head->next)
+        if (head->node != NULL && head->node->type == AST_PFX(WRITE)) return true;
+    return false;
+}
+
+ir_coro *ir_coro_lower(const ast_fn_node *const fn) {
+    if (ir_fn_suspends(fn) == false) return NULL;
+    size_t num_states = 1;
+    for (const ast_node_link *head = fn->body_head; head != NULL; head = head->next)
+        if (head->node != NULL && head->node->type == AST_PFX(WRITE)) num_states++;
+    ir_coro *c = calloc(1, sizeof(ir_coro) + sizeof(ir_coro_state) * num_states);
+    c->fn = fn;
+    c->num_states = num_states;
+    // split after each write at the top of the body
+    size_t k = 0;
+    c->states[0].resume = fn->body_head;
+    for (ast_node_link *head = fn->body_head; head != NULL; head = head->next) {
+        if (head->node == NULL || head->node->type != AST_PFX(WRITE)) continue;
+        c->states[k].suspend = head->node;
+        c->states[++k].resume = head->next;
+    }
+    const var_type_fn *type = fn->type->body.fn;
+    size_t num_symbols = type->num_args + type->num_locals;
+    bool *defined = calloc(num_symbols + 1, sizeof(bool)), *reads = calloc(num_symbols + 1, sizeof(bool));
+    for (size_t i = 0; i < type->num_args; i++) defined[type->args[i]->idx.stack] = true;
+    for (k = 0; k < num_states; k++) {
+        ir_coro_state *s = &c->states[k];
+        if (k > 0) mark_list(type->symbols, defined, true, c->states[k - 1].resume, s->resume);
+        memset(reads, 0, sizeof(bool) * (num_symbols + 1));
+        mark_list(type->symbols, reads, false, s->resume, NULL);
+        for (size_t i = 0; i < num_symbols; i++) if (defined[i] && reads[i]) s->num_live++;
+        s->live = malloc(sizeof(size_t) * (s->num_live + 1));
+        s->num_live = 0;
+        for (size_t i = 0; i < num_symbols; i++) if (defined[i] && reads[i]) s->live[s->num_live++] = i;
+        if (s->num_live > c->num_slots) c->num_slots = s->num_live;
+    }
+    free(defined);
+    free(reads);
+    return c;
+}
+
+void ir_coro_free(ir_coro *c) {
+    for (size_t i = 0; i < c->num_states; i++) free(c->states[i].live);
+    while (c->chunks != NULL) {
+        void *next = *(void**) c->chunks;
+        free(c->chunks);
+        c->chunks = next;
+    }
+    free(c);
+}
+
+ir_coro_frame *ir_coro_frame_alloc(ir_coro *const c) {
+    if (c->free_frames == NULL) {
+        // one allocation for many frames, the first word links the chunks
+        size_t size = sizeof(ir_coro_frame) + sizeof(var_data) * c->num_slots + sizeof(var_data*) * c->fn->num_captures;
+        char *chunk = malloc(sizeof(void*) + size * IR_CORO_FRAME_CHUNK);
+        if (chunk == NULL) return NULL;
+        *(void**) chunk = c->chunks;
+        c->chunks = chunk;
+        for (size_t i = IR_CORO_FRAME_CHUNK; i-- > 0;) {
+            ir_coro_frame *f = (ir_coro_frame*) (chunk + sizeof(void*) + size * i);
+            f->next = c->free_frames;
+            c->free_frames = f;
+        }
+    }
+    ir_coro_frame *f = c->free_frames;
+    c->free_frames = f->next;
+    f->next = NULL;
+    f->coro = c;
+    f->env = (var_data**) (f->slots + c->num_slots);
+    f->wait = NULL;
+    f->state = 0;
+    f->ret.u64 = 0;
+    return f;
+}
+
+void ir_coro_frame_free(ir_coro *const c, ir_coro_frame *f) {
+    f->next = c->free_frames;
+    c->free_frames = f;
+}
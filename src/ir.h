@@ -2,6 +2,7 @@
 #pragma once
 
 #include "infer.h"
+#include "var.h"
 
 #define IR_PFX(NAME) IR_##NAME
 
@@ -54,3 +55,43 @@ typedef struct {
     ir_fn *root_ir;
     ir_fn_local_stack fn_stack[];
 } ir_state;
+
+// a fn with writes at the top of its body is split after each of them into states
+// a suspended call keeps only the locals read after the write in its frame
+
+typedef struct {
+    ast_node_link *resume; // first statement run when the state is entered
+    const ast_node *suspend; // write that ends the state, null for the last state
+    size_t num_live;
+    size_t *live; // stack idxs defined before resume and read after it, slot i holds live[i]
+} ir_coro_state;
+
+typedef struct _ir_coro ir_coro;
+
+typedef struct _ir_coro_frame {
+    struct _ir_coro_frame *next; // in the free list or a queue of the runner
+    ir_coro *coro;
+    var_data **env; // room for the captures of the fn after the slots
+    void *wait; // set by the runner
+    size_t state;
+    var_data ret;
+    var_data slots[];
+} ir_coro_frame;
+
+typedef struct _ir_coro {
+    const ast_fn_node *fn;
+    size_t num_states, num_slots; // slots for the state with the most live locals
+    ir_coro_frame *free_frames; // not shared between threads
+    void *chunks; // frames are made IR_CORO_FRAME_CHUNK at a time
+    ir_coro_state states[];
+} ir_coro;
+
+bool ir_fn_suspends(const ast_fn_node *const fn);
+
+ir_coro *ir_coro_lower(const ast_fn_node *const fn); // null if the fn never suspends
+
+void ir_coro_free(ir_coro *c);
+
+ir_coro_frame *ir_coro_frame_alloc(ir_coro *const c);
+
+void ir_coro_frame_free(ir_coro *const c, ir_coro_frame *f);
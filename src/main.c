@@ -2,6 +2,7 @@
 #include "parser.h"
 #include "print_json.h"
 #include "infer.h"
+#include "run.h"
 
 int print_tokens(const char *const file) {
     int fd = file_open_r(file);
@@ -58,15 +59,83 @@ int print_infer(const char *const file) {
 }
 
 int print_ir(const char *const file) {
+    parser_state *pstate = parser_state_init();
+    parser_status ps = parse_module(pstate, file);
+    if (ps != PARSER_STATUS_PFX(DONE) && ps != PARSER_STATUS_PFX(NONE)) {
+        error_print_json(pstate->e, pstate->s);
+        parser_state_free(pstate);
+        return ps;
+    }
+    infer_state *istate = infer_state_init(pstate);
+    infer_status is = infer(istate);
+    if (is != INFER_STATUS_PFX(OK)) {
+        error_print_json(istate->e, istate->p->s);
+        infer_state_free(istate);
+        return is;
+    }
+    // the ast as run, with the marks of each pass
+    escape_stats stats = { .heap = 0 };
+    fork_mark(istate->p->root_fn);
+    fuse_mark(istate->p->root_fn);
+    capture_stats captures = { .fns = 0 };
+    capture_mark(istate->p->root_fn, &captures);
+    branch_stats branches = { .ifs = 0 };
+    branch_mark(istate->p->root_fn, &branches);
+    escape_mark(istate->p->root_fn, &stats);
+    own_stats own = { .moves = 0 };
+    own_mark(istate->p->root_fn, &own);
+    printf("{\"escape\":");
+    escape_stats_print_json(&stats);
+    printf(",\"own\":");
+    own_stats_print_json(&own);
+    printf(",\"capture\":");
+    capture_stats_print_json(&captures);
+    printf(",\"branch\":");
+    branch_stats_print_json(&branches);
+    printf(",\"root_fn\":");
+    ast_fn_node_print_json(istate->p->root_fn, istate->p->s);
+    putchar('}');
+    infer_state_free(istate);
     return 0;
 }
 
+int run_file(const char *const file) {
+    parser_state *pstate = parser_state_init();
+    parser_status ps = parse_module(pstate, file);
+    if (ps != PARSER_STATUS_PFX(DONE) && ps != PARSER_STATUS_PFX(NONE)) {
+        error_print_json(pstate->e, pstate->s);
+        parser_state_free(pstate);
+        return ps;
+    }
+    infer_state *istate = infer_state_init(pstate);
+    infer_status is = infer(istate);
+    if (is != INFER_STATUS_PFX(OK)) {
+        error_print_json(istate->e, istate->p->s);
+        infer_state_free(istate);
+        return is;
+    }
+    run_status rs = run_module(istate);
+    if (rs == RUN_STATUS_PFX(OK)) return 0;
+    run_status_print_json(rs);
+    return rs;
+}
+
+int print_memory(const char *const file) {
+    // after the run so the caches of the workers are back in the pool
+    int rc = run_file(file);
+    slab_stats stats;
+    slab_stats_get(&stats);
+    slab_stats_print_json(&stats);
+    return rc;
+}
+
 int usage(const char *const basefile) {
-    printf("Usage %s [-t(okens) -a(st) -i(nfer) -(i)r file.sc\n", basefile);
+    printf("Usage %s [-t(okens) -a(st) -i(nfer) -(i)r -m(emory)] file.sc\n", basefile);
     return 1;
 }
 
 int main(int argc, char *argv[]) {
+    if (argc == 2 && argv[1][0] != '-') return run_file(argv[1]);
     if (argc < 3) return usage(argv[0]);
     if (argv[1][0] == '-') {
         switch (argv[1][1]) {
@@ -78,10 +147,11 @@ int main(int argc, char *argv[]) {
                 return print_infer(argv[2]);
             case 'r':
                 return print_ir(argv[2]);
+            case 'm':
+                return print_memory(argv[2]);
             default:
                 break;
         }
     }
-    // TODO run
     return usage(argv[0]);
 }
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "type.h"
+
+#define NUM_STATUS_PFX(NAME) NUM_STATUS_##NAME
+
+typedef enum {
+    NUM_STATUS_PFX(OK),
+    NUM_STATUS_PFX(INVALID),
+    NUM_STATUS_PFX(OVERFLOW),
+    NUM_STATUS_PFX(_END_NUM_STATUS)
+} num_status;
+
+const char *num_status_string(num_status status);
+
+// only looks at len bytes so tokens can be parsed in place
+
+// digits only, out of range for the width of header is overflow
+num_status num_parse_int(const char *const buf, size_t len, var_type_header header, uint64_t *const v);
+
+// digits with an optional fraction and exponent, 1.5 1e9 2.5e-3
+num_status num_parse_f64(const char *const buf, size_t len, double *const v);
+
+// how many of the first len bytes are digits, 8 at a time
+size_t num_digits_len(const char *const buf, size_t len);
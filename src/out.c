@@ -0,0 +1,137 @@
+
+#include "out.h"
+
+out_buf *out_buf_init(int fd, aio *const io) {
+    out_buf *o = slab_alloc(sizeof(out_buf));
+    o->fd = fd;
+    o->len = 0;
+    o->io = io;
+    o->in_flight = false;
+    o->ok = true;
+    o->buf = o->bufs[0];
+    return o;
+}
+
+bool out_buf_free(out_buf *o) {
+    bool ok = out_buf_sync(o);
+    slab_free(o, sizeof(out_buf));
+    return ok;
+}
+
+static bool wait_in_flight(out_buf *const o) {
+    // the rest of a short write is written in place
+    while (o->in_flight == true) {
+        aio_wait(o->io, &o->req);
+        o->in_flight = false;
+        if (o->req.result <= 0) {
+            o->ok = false;
+        } else if ((size_t) o->req.result < o->req.len) {
+            aio_req_setup(&o->req, AIO_OP_PFX(WRITE), o->fd, (char*) o->req.buf + o->req.result, o->req.len - o->req.result, NULL, NULL);
+            aio_submit(o->io, &o->req);
+            o->in_flight = true;
+        }
+    }
+    return o->ok;
+}
+
+bool out_buf_flush(out_buf *const o) {
+    if (o->len == 0) return o->ok;
+    if (o->io == NULL) {
+        struct iovec iov = { .iov_base = o->buf, .iov_len = o->len };
+        o->len = 0;
+        return file_write_iov(o->fd, &iov, 1);
+    }
+    if (wait_in_flight(o) == false) return false;
+    aio_req_setup(&o->req, AIO_OP_PFX(WRITE), o->fd, o->buf, o->len, NULL, NULL);
+    aio_submit(o->io, &o->req);
+    o->in_flight = true;
+    o->buf = o->buf == o->bufs[0] ? o->bufs[1] : o->bufs[0];
+    o->len = 0;
+    return true;
+}
+
+bool out_buf_sync(out_buf *const o) {
+    bool ok = out_buf_flush(o);
+    if (o->io != NULL) ok = wait_in_flight(o) && ok;
+    return ok;
+}
+
+bool out_buf_busy(out_buf *const o) {
+    return o->in_flight == true && atomic_load_explicit(&o->req.done, memory_order_acquire) == false;
+}
+
+bool out_buf_write(out_buf *const o, const char *const data, size_t len) {
+    if (len <= OUT_BUF_SIZE - o->len) {
+        memcpy(o->buf + o->len, data, len);
+        o->len += len;
+        return true;
+    }
+    // the buffer in flight has to land first to keep the order
+    if (o->io != NULL && wait_in_flight(o) == false) return false;
+    struct iovec iov[2] = {
+        { .iov_base = o->buf, .iov_len = o->len },
+        { .iov_base = (void*) data, .iov_len = len }
+    };
+    bool ok = o->len > 0 ? file_write_iov(o->fd, iov, 2) : file_write_iov(o->fd, iov + 1, 1);
+    o->len = 0;
+    return ok;
+}
+
+size_t out_format_u64(uint64_t v, char *const dest) {
+    // two digits at a time from the back
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char tmp[20];
+    size_t i = sizeof(tmp);
+    while (v >= 100) {
+        size_t pair = (v % 100) * 2;
+        v /= 100;
+        tmp[--i] = pairs[pair + 1];
+        tmp[--i] = pairs[pair];
+    }
+    if (v >= 10) {
+        tmp[--i] = pairs[v * 2 + 1];
+        tmp[--i] = pairs[v * 2];
+    } else {
+        tmp[--i] = '0' + v;
+    }
+    memcpy(dest, tmp + i, sizeof(tmp) - i);
+    return sizeof(tmp) - i;
+}
+
+bool out_buf_u64(out_buf *const o, uint64_t v) {
+    if (OUT_BUF_SIZE - o->len < 20 && out_buf_flush(o) == false) return false;
+    o->len += out_format_u64(v, o->buf + o->len);
+    return true;
+}
+
+bool out_buf_i64(out_buf *const o, int64_t v) {
+    if (OUT_BUF_SIZE - o->len < 21 && out_buf_flush(o) == false) return false;
+    if (v < 0) o->buf[o->len++] = '-';
+    // negate as unsigned so INT64_MIN does not overflow
+    o->len += out_format_u64(v < 0 ? -(uint64_t) v : (uint64_t) v, o->buf + o->len);
+    return true;
+}
+
+bool out_buf_f64(out_buf *const o, double v) {
+    // shortest that reads back the same
+    char tmp[32];
+    int len = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        len = snprintf(tmp, sizeof(tmp), "%.*g", precision, v);
+        if (strtod(tmp, NULL) == v) break;
+    }
+    return out_buf_write(o, tmp, len);
+}
+
+bool out_buf_rope(out_buf *const o, const rope *const r) {
+    if (r->len <= OUT_BUF_SIZE - o->len) {
+        rope_copy_bytes(r, o->buf + o->len);
+        o->len += r->len;
+        return true;
+    }
+    // too big to copy, the leaves go out on their own
+    return out_buf_sync(o) && rope_write(o->fd, r);
+}
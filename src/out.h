@@ -0,0 +1,43 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "def.h"
+#include "slab.h"
+#include "file.h"
+#include "rope.h"
+#include "aio.h"
+
+typedef struct {
+    int fd;
+    size_t len; // of buf
+    aio *io; // if not null a full buffer is written while the other is filled
+    aio_req req;
+    bool in_flight, ok; // ok is false once an async write fails
+    char *buf, bufs[2][OUT_BUF_SIZE];
+} out_buf;
+
+out_buf *out_buf_init(int fd, aio *const io);
+
+bool out_buf_free(out_buf *o); // flushes and waits first
+
+bool out_buf_flush(out_buf *const o); // submits the buffer, with io it can still be in flight
+
+bool out_buf_sync(out_buf *const o); // flushes and waits for the write
+
+bool out_buf_busy(out_buf *const o); // a flush now would wait for the write in flight
+
+bool out_buf_write(out_buf *const o, const char *const data, size_t len); // large data goes out with the buffer in one writev
+
+size_t out_format_u64(uint64_t v, char *const dest); // dest needs 20 bytes
+
+bool out_buf_u64(out_buf *const o, uint64_t v);
+
+bool out_buf_i64(out_buf *const o, int64_t v);
+
+bool out_buf_f64(out_buf *const o, double v);
+
+bool out_buf_rope(out_buf *const o, const rope *const r);
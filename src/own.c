@@ -0,0 +1,162 @@
+#include "own.h"
+
+typedef struct {
+    const ast_fn_node *fn;
+    own_stats *stats;
+    bool *captured; // read by a fn defined in this one
+    bool *later; // read by a statement after the one being marked
+} own_state;
+
+static bool is_local_vec(const own_state *const state, const ast_node *const node) {
+    const symbol_table_bucket *b;
+    if (node == NULL || node->type != AST_PFX(VAR)) return false;
+    b = node->data.var;
+    return b->type != NULL && b->type->header == VAR_PFX(VEC) && symbol_table_has_bucket(state->fn->type->body.fn->symbols, b);
+}
+
+static void set_move(own_state *const state, ast_node *const node) {
+    node->move = true;
+    if (state->stats != NULL) state->stats->moves++;
+}
+
+static void reads(const own_state *const state, const ast_node *const node, bool *const set, bool all);
+
+static void reads_list(const own_state *const state, const ast_node_link *head, bool *const set, bool all) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) reads(state, head->node, set, all);
+}
+
+static void reads(const own_state *const state, const ast_node *const node, bool *const set, bool all) {
+    // sets the vars of this fn in node, if all is false only those read by fns defined in node
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VAR):
+            if (all == true && symbol_table_has_bucket(state->fn->type->body.fn->symbols, node->data.var)) set[node->data.var->symbol_idx] = true;
+            break;
+        case AST_PFX(VEC):
+            reads_list(state, node->data.vec->items_head, set, all);
+            break;
+        case AST_PFX(FN):
+            reads_list(state, node->data.fn->body_head, set, true);
+            break;
+        case AST_PFX(CALL):
+            reads(state, node->data.call->func, set, all);
+            for (size_t i = 0; i < node->data.call->num_args; i++) reads(state, node->data.call->args[i], set, all);
+            break;
+        case AST_PFX(IF):
+            for (const ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                reads(state, c->cond, set, all);
+                reads_list(state, c->body_head, set, all);
+            }
+            reads_list(state, node->data.ifn->else_head, set, all);
+            break;
+        default:
+            if (is_op(node) == false) break;
+            reads(state, node->data.op->left, set, all);
+            reads(state, node->data.op->right, set, all);
+            break;
+    }
+}
+
+static void mark_tail(own_state *const state, ast_node *const node) {
+    // nothing in the frame runs after the last value of the fn
+    if (is_local_vec(state, node) == true && state->captured[node->data.var->symbol_idx] == false) {
+        set_move(state, node);
+    } else if (node->type == AST_PFX(IF)) {
+        for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next)
+            if (c->body_tail != NULL && c->body_tail->node != NULL) mark_tail(state, c->body_tail->node);
+        if (node->data.ifn->else_tail != NULL && node->data.ifn->else_tail->node != NULL) mark_tail(state, node->data.ifn->else_tail->node);
+    }
+}
+
+static const ast_node *find_leaf(const ast_node *const node, const symbol_table_bucket *const b, bool chain) {
+    if (node->type == AST_PFX(VAR)) return node->data.var == b ? node : NULL;
+    if (chain == false || fuse_is_vec_op(node) == false) return NULL;
+    const ast_node *leaf = find_leaf(node->data.op->left, b, chain);
+    return leaf != NULL ? leaf : find_leaf(node->data.op->right, b, chain);
+}
+
+static void mark_move(own_state *const state, ast_node *const node) {
+    // x: y takes the vec of y when nothing after reads y
+    ast_node *right = node->data.op->right;
+    if (is_local_vec(state, right) == false) return;
+    if (right->data.var == node->data.op->left->data.var || state->captured[right->data.var->symbol_idx] == true || state->later[right->data.var->symbol_idx] == true) return;
+    set_move(state, right);
+}
+
+static void mark_reuse(own_state *const state, ast_node *const node) {
+    // the result has the type of the items of the vecs it is made from
+    ast_node *right = node->data.op->right;
+    if (is_local_vec(state, node->data.op->left) == false || fuse_is_vec_op(right) == false) return;
+    if (right->type != AST_PFX(ADD) && right->type != AST_PFX(SUB)) return;
+    ast_op_node *op = right->data.op;
+    const ast_node *leaf = find_leaf(op->left, node->data.op->left->data.var, op->fuse);
+    if (leaf == NULL) leaf = find_leaf(op->right, node->data.op->left->data.var, op->fuse);
+    if (leaf == NULL) return;
+    op->reuse = leaf;
+    if (state->stats != NULL) state->stats->reuses++;
+}
+
+static void mark_fn(own_stats *const stats, const ast_fn_node *const fn);
+
+static void mark_node(own_state *const state, ast_node *const node);
+
+static void mark_list(own_state *const state, ast_node_link *head) {
+    for (; head != NULL; head = head->next) if (head->node != NULL) mark_node(state, head->node);
+}
+
+static void mark_node(own_state *const state, ast_node *const node) {
+    if (node == NULL) return;
+    switch (node->type) {
+        case AST_PFX(VEC):
+            mark_list(state, node->data.vec->items_head);
+            break;
+        case AST_PFX(FN):
+            // the body runs in its own frame
+            mark_fn(state->stats, node->data.fn);
+            break;
+        case AST_PFX(CALL):
+            for (size_t i = 0; i < node->data.call->num_args; i++) mark_node(state, node->data.call->args[i]);
+            break;
+        case AST_PFX(IF):
+            for (ast_if_cond *c = node->data.ifn->conds_head; c != NULL; c = c->next) {
+                mark_node(state, c->cond);
+                mark_list(state, c->body_head);
+            }
+            mark_list(state, node->data.ifn->else_head);
+            break;
+        case AST_PFX(ASSIGN):
+            mark_reuse(state, node);
+            mark_node(state, node->data.op->right);
+            break;
+        default:
+            if (is_op(node) == false) break;
+            mark_node(state, node->data.op->left);
+            mark_node(state, node->data.op->right);
+            break;
+    }
+}
+
+static void mark_fn(own_stats *const stats, const ast_fn_node *const fn) {
+    size_t num_symbols = fn->type->body.fn->symbols->symbol_counter, num_stmts = 0, i = 0;
+    own_state state = { .fn = fn, .stats = stats };
+    state.captured = calloc(num_symbols + 1, sizeof(bool));
+    state.later = calloc(num_symbols + 1, sizeof(bool));
+    for (ast_node_link *head = fn->body_head; head != NULL; head = head->next) if (head->node != NULL) num_stmts++;
+    ast_node **stmts = calloc(num_stmts + 1, sizeof(ast_node*));
+    for (ast_node_link *head = fn->body_head; head != NULL; head = head->next) if (head->node != NULL) stmts[i++] = head->node;
+    for (i = 0; i < num_stmts; i++) reads(&state, stmts[i], state.captured, false);
+    // statements are marked last to first so later holds what is still read
+    for (i = num_stmts; i-- > 0;) {
+        if (i + 1 == num_stmts) mark_tail(&state, stmts[i]);
+        else if (stmts[i]->type == AST_PFX(ASSIGN)) mark_move(&state, stmts[i]);
+        reads(&state, stmts[i], state.later, true);
+        mark_node(&state, stmts[i]);
+    }
+    free(stmts);
+    free(state.captured);
+    free(state.later);
+}
+
+void own_mark(ast_fn_node *const root, own_stats *const stats) {
+    mark_fn(stats, root);
+}
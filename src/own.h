@@ -0,0 +1,13 @@
+#pragma once
+
+#include "fuse.h"
+
+typedef struct {
+    size_t moves, reuses;
+} own_stats;
+
+// vecs are counted, only reads that keep the value take a ref and operands are borrowed
+// a vec var read by an assign or as the last value of a fn is moved out of the frame
+// when it is not read again, which removes the ref taken by the read and the drop when the frame is freed
+// an assign of a vec op to one of its leaf vars marks the op to write into that vec when it has one owner
+void own_mark(ast_fn_node *const root, own_stats *const stats); // stats can be null, needs fuse_mark first
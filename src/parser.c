@@ -23,10 +23,12 @@ const char *parser_status_string(parser_status status) {
         "CANNOT_OPEN_FILE",
         "CANNOT_READ_FILE",
         "CANNOT_CLOSE_FILE",
+        "INVALID_UTF8",
         "MODE_PUSH_FAIL",
         "MODE_POP_FAIL",
         "VAR_INSERT_FAIL",
         "INVALID_INT",
+        "INVALID_FLOAT",
         "INVALID_VEC",
         "INVALID_FN",
         "INVALID_CALL",
@@ -238,6 +240,8 @@ static ast_fn_node *parse_fn(parser_state *const state, ast_fn_node *const paren
             return NULL;
         }
         b->type = arg_type;
+        // args are the first slots of the frame in order, locals follow
+        b->idx.stack = cur_fn->type->body.fn->num_args;
         cur_fn->type->body.fn->args[cur_fn->type->body.fn->num_args++] = b;
         // inc arg count
         if (cur_fn->type->body.fn->num_args >= AST_MAX_ARGS) {
@@ -400,7 +404,8 @@ parser_status parse_stmt(parser_state *const state, ast_fn_node *const cur_fn, a
     token_status ts;
     symbol_table_bucket *b = NULL;
     ast_node *n = NULL, *value_tmp = NULL, *cur_node = NULL;
-    int64_t intv;
+    uint64_t intv;
+    double fv;
     utf8 cv;
     ast_fn_node *fn, *parent;
     ast_if_node *if_node;
@@ -431,7 +436,7 @@ parser_status parse_stmt(parser_state *const state, ast_fn_node *const cur_fn, a
                         return parser_error(state, PARSER_STATUS_PFX(VAR_INSERT_FAIL));
                     }
                     // inc local count
-                    cur_fn->type->body.fn->num_locals++;
+                    b->idx.stack = cur_fn->type->body.fn->num_args + cur_fn->type->body.fn->num_locals++;
                     n = ast_node_init(AST_PFX(VAR), (ast_data) { .var = b }, state->next);
                 } else {
                     // check if fn call
@@ -441,9 +446,14 @@ parser_status parse_stmt(parser_state *const state, ast_fn_node *const cur_fn, a
                 b = NULL;
                 break;
             case TOKEN_PFX(INT):
-                intv = strtol(state->s->buffer + state->next->start_idx, NULL, 10);
-                if (errno == ERANGE) return parser_error(state, PARSER_STATUS_PFX(INVALID_INT));
-                n = ast_node_init(AST_PFX(INT), (ast_data) { .intv = intv }, state->next);
+                if (num_parse_int(state->s->buffer + state->next->start_idx, token_len(state->next), VAR_PFX(U64), &intv) != NUM_STATUS_PFX(OK))
+                    return parser_error(state, PARSER_STATUS_PFX(INVALID_INT));
+                n = ast_node_init(AST_PFX(INT), (ast_data) { .intv = (int64_t) intv }, state->next);
+                break;
+            case TOKEN_PFX(FLOAT):
+                if (num_parse_f64(state->s->buffer + state->next->start_idx, token_len(state->next), &fv) != NUM_STATUS_PFX(OK))
+                    return parser_error(state, PARSER_STATUS_PFX(INVALID_FLOAT));
+                n = ast_node_init(AST_PFX(FLOAT), (ast_data) { .fv = fv }, state->next);
                 break;
             case TOKEN_PFX(CHAR):
                 // grab char at index[1] index[0] is "
@@ -453,11 +463,18 @@ parser_status parse_stmt(parser_state *const state, ast_fn_node *const cur_fn, a
                         case 'n':
                             cv = utf8_from_c_char('\n');
                             break;
+                        case 't':
+                            cv = utf8_from_c_char('\t');
+                            break;
+                        case '0':
+                            cv = utf8_from_c_char('\0');
+                            break;
                         default:
+                            cv = utf8_from_c_char(state->s->buffer[state->next->start_idx + 2]);
                             break;
                     }
                 } else {
-                    cv = utf8_from_c_char(state->s->buffer[state->next->start_idx + 1]);
+                    cv = utf8_from_bytes(state->s->buffer + state->next->start_idx + 1);
                 }
                 n = ast_node_init(AST_PFX(CHAR), (ast_data) { .cv = cv  }, state->next);
                 break;
@@ -591,6 +608,19 @@ parser_status parse_module(parser_state *const state, const char *const filename
         string_free(state->s);
         return parser_error(state, PARSER_STATUS_PFX(CANNOT_CLOSE_FILE));
     }
+    size_t valid = utf8_validate(state->s->buffer, state->s->len);
+    if (valid != state->s->len) {
+        // point the error at the bad byte
+        state->next->start_idx = state->next->end_idx = valid;
+        for (size_t i = 0; i < valid; i++) {
+            if (state->s->buffer[i] == '\n') {
+                state->next->line_no++;
+                state->next->char_no = 0;
+            }
+            if (((uint8_t) state->s->buffer[i] & 0xC0) != 0x80) state->next->char_no++;
+        }
+        return parser_error(state, PARSER_STATUS_PFX(INVALID_UTF8));
+    }
     if (parser_mode_push(state, PARSER_MODE_PFX(MODULE)) == false) {
         string_free(state->s);
         return parser_error(state, PARSER_STATUS_PFX(MODE_PUSH_FAIL));
@@ -5,6 +5,7 @@
 #include "ast.h"
 #include "def.h"
 #include "error.h"
+#include "num.h"
 
 #define PARSER_MODE_PFX(NAME) PARSER_MODE_##NAME
 
@@ -31,11 +32,13 @@ typedef enum {
     PARSER_STATUS_PFX(CANNOT_OPEN_FILE),
     PARSER_STATUS_PFX(CANNOT_READ_FILE),
     PARSER_STATUS_PFX(CANNOT_CLOSE_FILE),
+    PARSER_STATUS_PFX(INVALID_UTF8),
     // Parser Error
     PARSER_STATUS_PFX(MODE_PUSH_FAIL),
     PARSER_STATUS_PFX(MODE_POP_FAIL),
     PARSER_STATUS_PFX(VAR_INSERT_FAIL),
     PARSER_STATUS_PFX(INVALID_INT),
+    PARSER_STATUS_PFX(INVALID_FLOAT),
     PARSER_STATUS_PFX(INVALID_VEC),
     PARSER_STATUS_PFX(INVALID_FN),
     PARSER_STATUS_PFX(INVALID_CALL),
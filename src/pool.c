@@ -0,0 +1,207 @@
+
+#include "pool.h"
+
+static _Thread_local pool_worker *cur_worker = NULL;
+
+extern inline void pool_task_setup(pool_task *const task, void (*fn)(void *arg), void *arg);
+
+size_t pool_default_num_workers(void) {
+    const char *env = getenv("SC_THREADS");
+    long n = env != NULL ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return n > POOL_MAX_WORKERS ? POOL_MAX_WORKERS : (size_t) n;
+}
+
+static void task_run(pool_task *const task) {
+    if (task->detached) {
+        task->fn(task->arg);
+        return;
+    }
+    task->fn(task->arg);
+    atomic_store_explicit(&task->done, true, memory_order_release);
+}
+
+static bool deque_push(pool_deque *const d, pool_task *const task) {
+    long long bottom = atomic_load_explicit(&d->bottom, memory_order_relaxed), top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (bottom - top >= POOL_DEQUE_SIZE) return false;
+    atomic_store_explicit(&d->tasks[bottom % POOL_DEQUE_SIZE], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+static pool_task *deque_pop(pool_deque *const d) {
+    long long bottom = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (top > bottom) {
+        atomic_store_explicit(&d->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+    pool_task *task = atomic_load_explicit(&d->tasks[bottom % POOL_DEQUE_SIZE], memory_order_relaxed);
+    if (top == bottom) {
+        // last task, race the thieves for it
+        if (atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed) == false) task = NULL;
+        atomic_store_explicit(&d->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static pool_task *deque_steal(pool_deque *const d) {
+    long long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (top >= bottom) return NULL;
+    pool_task *task = atomic_load_explicit(&d->tasks[top % POOL_DEQUE_SIZE], memory_order_relaxed);
+    if (atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed) == false) return NULL;
+    return task;
+}
+
+static size_t next_victim(pool_worker *const w) {
+    // xorshift
+    w->seed ^= w->seed << 13;
+    w->seed ^= w->seed >> 17;
+    w->seed ^= w->seed << 5;
+    return w->seed;
+}
+
+static pool_task *pool_find_task(pool *const p, pool_worker *const w) {
+    // own deque newest first then oldest task of a random victim
+    pool_task *task;
+    if ((task = deque_pop(&w->deque)) == NULL && p->num_workers > 1) {
+        size_t start = next_victim(w) % p->num_workers;
+        for (size_t i = 0; i < p->num_workers && task == NULL; i++) {
+            size_t victim = (start + i) % p->num_workers;
+            if (victim != w->idx) task = deque_steal(&p->workers[victim].deque);
+        }
+    }
+    if (task != NULL) atomic_fetch_sub(&p->pending, 1);
+    return task;
+}
+
+static void *worker_loop(void *arg) {
+    pool_worker *w = arg;
+    pool *p = w->p;
+    cur_worker = w;
+    while (atomic_load(&p->stop) == false) {
+        pool_task *task = pool_find_task(p, w);
+        if (task != NULL) {
+            task_run(task);
+            continue;
+        }
+        pthread_mutex_lock(&p->idle_lock);
+        atomic_fetch_add(&p->sleeping, 1);
+        if (atomic_load(&p->pending) == 0 && atomic_load(&p->stop) == false) pthread_cond_wait(&p->idle, &p->idle_lock);
+        atomic_fetch_sub(&p->sleeping, 1);
+        pthread_mutex_unlock(&p->idle_lock);
+    }
+    return NULL;
+}
+
+pool *pool_init(size_t num_workers) {
+    if (num_workers < 1) num_workers = 1;
+    if (num_workers > POOL_MAX_WORKERS) num_workers = POOL_MAX_WORKERS;
+    size_t bytes = sizeof(pool) + sizeof(pool_worker) * num_workers;
+    pool *p = aligned_alloc(CACHE_LINE_SIZE, (bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+    memset(p, 0, bytes);
+    p->num_workers = num_workers;
+    pthread_mutex_init(&p->idle_lock, NULL);
+    pthread_cond_init(&p->idle, NULL);
+    for (size_t i = 0; i < num_workers; i++) {
+        p->workers[i].p = p;
+        p->workers[i].idx = i;
+        p->workers[i].seed = i + 1;
+    }
+    cur_worker = &p->workers[0];
+    // SC_WORKER_STACK_MB sizes each worker stack, only the pages used are backed
+    pthread_attr_t attr;
+    bool has_attr = pthread_attr_init(&attr) == 0;
+    bool big = has_attr == true && pthread_attr_setstacksize(&attr, stack_native_size("SC_WORKER_STACK_MB", POOL_STACK_SIZE)) == 0;
+    for (size_t i = 1; i < num_workers; i++) {
+        if ((big == false || pthread_create(&p->workers[i].thread, &attr, worker_loop, &p->workers[i]) != 0)
+            && pthread_create(&p->workers[i].thread, NULL, worker_loop, &p->workers[i]) != 0) {
+            // run with the workers we have
+            p->num_workers = i;
+            break;
+        }
+    }
+    if (has_attr == true) pthread_attr_destroy(&attr);
+    return p;
+}
+
+void pool_free(pool *p) {
+    pthread_mutex_lock(&p->idle_lock);
+    atomic_store(&p->stop, true);
+    pthread_cond_broadcast(&p->idle);
+    pthread_mutex_unlock(&p->idle_lock);
+    for (size_t i = 1; i < p->num_workers; i++) pthread_join(p->workers[i].thread, NULL);
+    pthread_mutex_destroy(&p->idle_lock);
+    pthread_cond_destroy(&p->idle);
+    if (cur_worker != NULL && cur_worker->p == p) cur_worker = NULL;
+    free(p);
+}
+
+void pool_fork(pool *const p, pool_task *const task) {
+    if (cur_worker == NULL || cur_worker->p != p) {
+        task_run(task);
+        return;
+    }
+    // counted before it can be stolen so pending never drops below the tasks in the deques
+    atomic_fetch_add(&p->pending, 1);
+    if (deque_push(&cur_worker->deque, task) == false) {
+        atomic_fetch_sub(&p->pending, 1);
+        task_run(task);
+        return;
+    }
+    if (atomic_load(&p->sleeping) > 0) {
+        pthread_mutex_lock(&p->idle_lock);
+        pthread_cond_signal(&p->idle);
+        pthread_mutex_unlock(&p->idle_lock);
+    }
+}
+
+bool pool_help(pool *const p) {
+    pool_task *task = cur_worker != NULL && cur_worker->p == p ? pool_find_task(p, cur_worker) : NULL;
+    if (task == NULL) return false;
+    task_run(task);
+    return true;
+}
+
+void pool_join(pool *const p, pool_task *const task) {
+    while (atomic_load_explicit(&task->done, memory_order_acquire) == false)
+        if (pool_help(p) == false) sched_yield();
+}
+
+typedef struct {
+    pool_task task;
+    void (*fn)(void *arg, size_t start, size_t end);
+    void *arg;
+    size_t start, end;
+} pool_range;
+
+static void range_run(void *arg) {
+    pool_range *r = arg;
+    r->fn(r->arg, r->start, r->end);
+}
+
+void pool_for(pool *const p, size_t len, size_t grain, void (*fn)(void *arg, size_t start, size_t end), void *arg) {
+    size_t num_ranges = grain > 0 ? (len + grain - 1) / grain : 1;
+    if (p == NULL || num_ranges <= 1) {
+        fn(arg, 0, len);
+        return;
+    }
+    pool_range *ranges = slab_alloc(sizeof(pool_range) * num_ranges);
+    for (size_t i = 0; i < num_ranges; i++) {
+        ranges[i].fn = fn;
+        ranges[i].arg = arg;
+        ranges[i].start = i * grain;
+        ranges[i].end = len - ranges[i].start < grain ? len : ranges[i].start + grain;
+        pool_task_setup(&ranges[i].task, range_run, &ranges[i]);
+    }
+    // thieves take the last ranges while this thread works from the front
+    for (size_t i = num_ranges; i-- > 1;) pool_fork(p, &ranges[i].task);
+    range_run(&ranges[0]);
+    for (size_t i = 1; i < num_ranges; i++) pool_join(p, &ranges[i].task);
+    slab_free(ranges, sizeof(pool_range) * num_ranges);
+}
@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "def.h"
+#include "slab.h"
+#include "stack.h"
+
+typedef struct _pool_task {
+    void (*fn)(void *arg);
+    void *arg;
+    atomic_bool done;
+    bool detached; // never joined, fn can free or queue the task again so done is not set
+} pool_task;
+
+inline void pool_task_setup(pool_task *const task, void (*fn)(void *arg), void *arg) {
+    task->fn = fn;
+    task->arg = arg;
+    atomic_init(&task->done, false);
+    task->detached = false;
+}
+
+typedef struct {
+    // chase lev, the owner pushes and pops at the bottom and thieves take from the top
+    atomic_llong top, bottom;
+    _Atomic(pool_task*) tasks[POOL_DEQUE_SIZE];
+} pool_deque;
+
+typedef struct _pool pool;
+
+typedef struct {
+    pool *p;
+    size_t idx;
+    pthread_t thread;
+    unsigned int seed; // for picking a victim
+    _Alignas(CACHE_LINE_SIZE) pool_deque deque; // workers do not share a line
+} pool_worker;
+
+typedef struct _pool {
+    size_t num_workers; // worker 0 is the thread that created the pool
+    atomic_bool stop;
+    atomic_size_t pending, sleeping; // tasks in deques, workers waiting on idle
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle;
+    pool_worker workers[];
+} pool;
+
+size_t pool_default_num_workers(void); // SC_THREADS or the number of cpus
+
+pool *pool_init(size_t num_workers);
+
+void pool_free(pool *p);
+
+void pool_fork(pool *const p, pool_task *const task); // runs the task inline if it cannot be queued
+
+bool pool_help(pool *const p); // runs one queued task if there is one
+
+void pool_join(pool *const p, pool_task *const task); // runs other tasks until task is done
+
+// splits [0, len) into chunks of grain items and runs fn on each across the pool
+// chunks only depend on len and grain so results combined in chunk order match for any number of workers
+void pool_for(pool *const p, size_t len, size_t grain, void (*fn)(void *arg, size_t start, size_t end), void *arg);
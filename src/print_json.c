@@ -63,16 +63,14 @@ void var_type_print_json(const var_type *const t) {
     printf("{\"header\":\"%s\",\"body\":", var_type_header_string(t->header));
     switch (t->header) {
         case VAR_PFX(VEC):
-            if (t->body.vec->len > 0) {
-                printf("{\"len\":%lu,\"items\":[", t->body.vec->len);
-                for (size_t i = 0; i < t->body.vec->len; i++) {
-                    var_type_print_json(t->body.vec->items[i]);
-                    if (i + 1 < t->body.vec->len) putchar(',');
-                }
-                printf("]}");
-            } else {
-                // TODO dynamic vec
+            printf("{\"len\":%lu,\"dynamic\":", t->body.vec->len);
+            var_type_print_json(t->body.vec->dynamic);
+            printf(",\"items\":[");
+            for (size_t i = 0; i < t->body.vec->len; i++) {
+                var_type_print_json(t->body.vec->items[i]);
+                if (i + 1 < t->body.vec->len) putchar(',');
             }
+            printf("]}");
             break;
         case VAR_PFX(FN):
             printf("{\"num_args\":%lu,\"num_locals\":%lu,\"return_type\":", t->body.fn->num_args, t->body.fn->num_locals);
@@ -106,7 +104,7 @@ void ast_node_link_print_json(ast_node_link *head, const string *const s) {
 }
 
 void ast_vec_node_print_json(const ast_vec_node *const vec, const string *const s) {
-    printf("{\"num_items\":%lu,\"type\":", vec->num_items);
+    printf("{\"num_items\":%lu,\"alloc\":\"%s\",\"type\":", vec->num_items, ast_alloc_string(vec->alloc));
     if (vec->type != NULL) var_type_print_json(vec->type);
     else printf("null");
     putchar(',');
@@ -121,13 +119,15 @@ void ast_fn_node_print_json(const ast_fn_node *const fn, const string *const s)
     printf(",\"parent\":");
     if (fn->parent != NULL) printf("\"[struct parent]\"");
     else printf("null");
-    printf(",\"body\":");
+    printf(",\"captures\":[");
+    for (size_t i = 0; i < fn->num_captures; i++) printf("%s\"%s\"", i > 0 ? "," : "", fn->captures[i]->symbol);
+    printf("],\"body\":");
     ast_node_link_print_json(fn->body_head, s);
     putchar('}');
 }
 
 void ast_call_node_print_json(const ast_call_node *const c, const string *const s) {
-    printf("{\"num_args\":%lu,\"func\":", c->num_args);
+    printf("{\"num_args\":%lu,\"known\":%s,\"func\":", c->num_args, c->target != NULL ? "true" : "false");
     ast_node_print_json(c->func, s);
     printf(",\"args\":[");
     for (size_t i = 0; i < c->num_args; i++) {
@@ -153,6 +153,12 @@ void ast_if_node_print_json(const ast_if_node *const if_node, const string *cons
     }
     printf("],\"else\":");
     ast_node_link_print_json(if_node->else_head, s);
+    if (if_node->branch != NULL) {
+        // costs are nodes run to find the arm
+        const ast_branch *b = if_node->branch;
+        printf(",\"branch\":{\"kind\":\"%s\",\"reason\":\"%s\",\"arms\":%lu,\"ranges\":%lu,\"select\":%s,\"cost\":{\"linear\":%lu,\"tree\":%lu,\"table\":%lu}}",
+            ast_branch_kind_string(b->kind), b->reason, b->num_arms, b->num_ranges, b->select ? "true" : "false", b->linear_cost, b->tree_cost, b->table_cost);
+    }
     putchar('}');
 }
 
@@ -168,15 +174,18 @@ void ast_node_print_json(const ast_node *const node, const string *const s) {
         case AST_PFX(INT):
             printf("{\"intv\":%li}", node->data.intv);
             break;
+        case AST_PFX(FLOAT):
+            printf("{\"fv\":%.17g}", node->data.fv);
+            break;
         case AST_PFX(CHAR):
-            // TODO utf8 char
             printf("{\"cv\":\"");
             switch (node->data.cv.c[0]) {
                 case '\n':
                     printf("\\n");
                     break;
                 default:
-                    putchar(node->data.cv.c[0]);
+                    // json strings are utf8 so multibyte chars go out as is
+                    fwrite(node->data.cv.c, 1, utf8_char_len(node->data.cv.c[0]), stdout);
                     break;
             }
             printf("\"}");
@@ -198,6 +207,8 @@ void ast_node_print_json(const ast_node *const node, const string *const s) {
                 // op node
                 printf("{\"return_type\":");
                 var_type_print_json(node->data.op->return_type);
+                if (node->data.op->return_type != NULL && node->data.op->return_type->header == VAR_PFX(VEC))
+                    printf(",\"fuse\":%s,\"alloc\":\"%s\",\"reuse\":%s", node->data.op->fuse ? "true" : "false", ast_alloc_string(node->data.op->alloc), node->data.op->reuse != NULL ? "true" : "false");
                 printf(",\"left\":");
                 ast_node_print_json(node->data.op->left, s);
                 printf(",\"right\":");
@@ -214,6 +225,42 @@ void ast_node_print_json(const ast_node *const node, const string *const s) {
     putchar('}');
 }
 
+void escape_stats_print_json(const escape_stats *const stats) {
+    // every frame or none site is a heap allocation removed each time it runs
+    printf("{\"sites\":%lu,\"heap\":%lu,\"frame\":%lu,\"none\":%lu,\"removed\":%lu}",
+        stats->heap + stats->frame + stats->none, stats->heap, stats->frame, stats->none, stats->frame + stats->none);
+}
+
+void own_stats_print_json(const own_stats *const stats) {
+    // each move is a ref and a drop not done, each reuse a vec not made when the var has the only ref
+    printf("{\"moves\":%lu,\"reuses\":%lu}", stats->moves, stats->reuses);
+}
+
+void capture_stats_print_json(const capture_stats *const stats) {
+    // lifted fns and known calls build no env, the rest copy one pointer per capture
+    printf("{\"fns\":%lu,\"lifted\":%lu,\"captures\":%lu,\"known_calls\":%lu}", stats->fns, stats->lifted, stats->captures, stats->known_calls);
+}
+
+void branch_stats_print_json(const branch_stats *const stats) {
+    printf("{\"ifs\":%lu,\"linear\":%lu,\"tree\":%lu,\"table\":%lu,\"select\":%lu}", stats->ifs, stats->linear, stats->tree, stats->table, stats->select);
+}
+
+void slab_stats_print_json(const slab_stats *const stats) {
+    // fragmentation is the part of the mapped slabs not asked for, free objects and rounding up to the class
+    printf("{\"classes\":[");
+    bool first = true;
+    for (size_t c = 0; c < SLAB_NUM_CLASSES; c++) {
+        const slab_class_stats *s = &stats->classes[c];
+        if (s->slabs == 0) continue;
+        if (first == false) putchar(',');
+        first = false;
+        size_t mapped = s->slabs * s->slab_size;
+        printf("{\"size\":%lu,\"slab_size\":%lu,\"slabs\":%lu,\"objects\":%lu,\"in_use\":%lu,\"free\":%lu,\"requested\":%lu,\"fragmentation\":%.4f}",
+            s->size, s->slab_size, s->slabs, s->objects, s->in_use, s->objects - s->in_use, s->requested, 1.0 - (double) s->requested / mapped);
+    }
+    printf("],\"large\":%lu,\"large_bytes\":%lu}", stats->large, stats->large_bytes);
+}
+
 void error_print_json(const error *const e, const string *const s) {
     printf("{\"type\":\"%s\",", error_type_string(e->type));
     switch (e->type) {
@@ -246,3 +293,8 @@ void error_print_json(const error *const e, const string *const s) {
     }
     putchar('}');
 }
+
+void run_status_print_json(run_status status) {
+    // stdout has the output of the script so the status goes to stderr
+    fprintf(stderr, "{\"type\":\"RUN\",\"status\":\"%s\"}\n", run_status_string(status));
+}
@@ -6,6 +6,12 @@
 #include "parser.h"
 #include "error.h"
 #include "infer.h"
+#include "escape.h"
+#include "own.h"
+#include "capture.h"
+#include "branch.h"
+#include "slab.h"
+#include "run.h"
 
 void token_print_json(const token *const t, const string *const s);
 
@@ -27,4 +33,16 @@ void ast_if_node_print_json(const ast_if_node *const if_node, const string *cons
 
 void ast_node_print_json(const ast_node *const node, const string *const s);
 
+void escape_stats_print_json(const escape_stats *const stats);
+
+void own_stats_print_json(const own_stats *const stats);
+
+void capture_stats_print_json(const capture_stats *const stats);
+
+void branch_stats_print_json(const branch_stats *const stats);
+
+void slab_stats_print_json(const slab_stats *const stats);
+
 void error_print_json(const error *const e, const string *const s);
+
+void run_status_print_json(run_status status);
@@ -0,0 +1,145 @@
+
+#include "pvec.h"
+
+extern inline pvec *pvec_copy(pvec *const v);
+
+static pvec_node *node_init(void) {
+    pvec_node *n = slab_alloc(sizeof(pvec_node));
+    memset(n, 0, sizeof(pvec_node));
+    atomic_init(&n->refs, 1);
+    return n;
+}
+
+static void node_release(pvec_node *const n, size_t level) {
+    if (n == NULL || atomic_fetch_sub(&n->refs, 1) > 1) return;
+    if (level > 0) for (size_t i = 0; i < PVEC_WIDTH; i++) node_release(n->children[i], level - PVEC_BITS);
+    slab_free(n, sizeof(pvec_node));
+}
+
+static pvec_node *node_own(pvec_node *const n, size_t level) {
+    // takes a ref to n and returns a node only the caller points to
+    if (atomic_load(&n->refs) == 1) return n;
+    pvec_node *copy = node_init();
+    memcpy(copy->items, n->items, sizeof(copy->items));
+    if (level > 0) {
+        for (size_t i = 0; i < PVEC_WIDTH; i++)
+            if (copy->children[i] != NULL) atomic_fetch_add(&copy->children[i]->refs, 1);
+    }
+    node_release(n, level);
+    return copy;
+}
+
+static size_t tail_offset(const pvec *const v) {
+    return v->len < PVEC_WIDTH ? 0 : ((v->len - 1) >> PVEC_BITS) << PVEC_BITS;
+}
+
+pvec *pvec_init(void) {
+    pvec *v = slab_alloc(sizeof(pvec));
+    memset(v, 0, sizeof(pvec));
+    atomic_init(&v->refs, 1);
+    v->shift = PVEC_BITS;
+    v->root = node_init();
+    v->tail = node_init();
+    return v;
+}
+
+void pvec_free(pvec *v) {
+    if (atomic_fetch_sub(&v->refs, 1) > 1) return;
+    node_release(v->root, v->shift);
+    node_release(v->tail, 0);
+    slab_free(v, sizeof(pvec));
+}
+
+var_value pvec_get(const pvec *const v, size_t idx) {
+    if (idx >= tail_offset(v)) return v->tail->items[idx & PVEC_MASK];
+    const pvec_node *n = v->root;
+    for (size_t level = v->shift; level > 0; level -= PVEC_BITS) n = n->children[(idx >> level) & PVEC_MASK];
+    return n->items[idx & PVEC_MASK];
+}
+
+pvec *pvec_transient(pvec *const v) {
+    pvec *t = slab_alloc(sizeof(pvec));
+    memset(t, 0, sizeof(pvec));
+    atomic_init(&t->refs, 1);
+    t->len = v->len;
+    t->shift = v->shift;
+    t->root = v->root;
+    t->tail = v->tail;
+    atomic_fetch_add(&t->root->refs, 1);
+    atomic_fetch_add(&t->tail->refs, 1);
+    return t;
+}
+
+void pvec_set_in_place(pvec *const t, size_t idx, var_value value) {
+    if (idx >= tail_offset(t)) {
+        t->tail = node_own(t->tail, 0);
+        t->tail->items[idx & PVEC_MASK] = value;
+        return;
+    }
+    t->root = node_own(t->root, t->shift);
+    pvec_node *n = t->root;
+    for (size_t level = t->shift; level > 0; level -= PVEC_BITS) {
+        pvec_node **child = &n->children[(idx >> level) & PVEC_MASK];
+        *child = node_own(*child, level - PVEC_BITS);
+        n = *child;
+    }
+    n->items[idx & PVEC_MASK] = value;
+}
+
+static pvec_node *new_path(size_t level, pvec_node *const leaf) {
+    if (level == 0) return leaf;
+    pvec_node *n = node_init();
+    n->children[0] = new_path(level - PVEC_BITS, leaf);
+    return n;
+}
+
+static pvec_node *push_tail(const pvec *const t, size_t level, pvec_node *parent, pvec_node *const tail) {
+    // takes the refs to parent and tail
+    parent = node_own(parent, level);
+    size_t sub = ((t->len - 1) >> level) & PVEC_MASK;
+    if (level == PVEC_BITS) parent->children[sub] = tail;
+    else if (parent->children[sub] != NULL) parent->children[sub] = push_tail(t, level - PVEC_BITS, parent->children[sub], tail);
+    else parent->children[sub] = new_path(level - PVEC_BITS, tail);
+    return parent;
+}
+
+void pvec_push_in_place(pvec *const t, var_value value) {
+    size_t tail_len = t->len - tail_offset(t);
+    if (tail_len < PVEC_WIDTH) {
+        t->tail = node_own(t->tail, 0);
+        t->tail->items[tail_len] = value;
+        t->len++;
+        return;
+    }
+    // the full tail moves into the tree, a new level is added when the root is full
+    if ((t->len >> PVEC_BITS) > ((size_t) 1 << t->shift)) {
+        pvec_node *root = node_init();
+        root->children[0] = t->root;
+        root->children[1] = new_path(t->shift, t->tail);
+        t->root = root;
+        t->shift += PVEC_BITS;
+    } else {
+        t->root = push_tail(t, t->shift, t->root, t->tail);
+    }
+    t->tail = node_init();
+    t->tail->items[0] = value;
+    t->len++;
+}
+
+pvec *pvec_set(pvec *const v, size_t idx, var_value value) {
+    pvec *t = pvec_transient(v);
+    pvec_set_in_place(t, idx, value);
+    return t;
+}
+
+pvec *pvec_push(pvec *const v, var_value value) {
+    pvec *t = pvec_transient(v);
+    pvec_push_in_place(t, value);
+    return t;
+}
+
+pvec *pvec_from_values(const var_value *const values, size_t len) {
+    pvec *t = pvec_init();
+    for (size_t i = 0; i < len; i++) pvec_push_in_place(t, values[i]);
+    return t;
+}
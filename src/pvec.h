@@ -0,0 +1,55 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "def.h"
+#include "slab.h"
+
+typedef uint64_t var_value; // tagged value from var.h
+
+#define PVEC_WIDTH ((size_t) 1 << PVEC_BITS)
+
+#define PVEC_MASK (PVEC_WIDTH - 1)
+
+typedef struct _pvec_node {
+    atomic_size_t refs; // shared by every version and parent that points to it
+    union {
+        struct _pvec_node *children[PVEC_WIDTH];
+        var_value items[PVEC_WIDTH];
+    };
+} pvec_node;
+
+typedef struct {
+    atomic_size_t refs;
+    size_t len, shift; // shift is PVEC_BITS times the levels above the leaves
+    pvec_node *root, *tail; // the last items are kept out of the tree so most pushes only touch the tail
+} pvec;
+
+pvec *pvec_init(void);
+
+inline pvec *pvec_copy(pvec *const v) {
+    atomic_fetch_add(&v->refs, 1);
+    return v;
+}
+
+void pvec_free(pvec *v);
+
+var_value pvec_get(const pvec *const v, size_t idx);
+
+// a new version that shares the tree with v, nodes are copied the first time they are changed
+pvec *pvec_transient(pvec *const v);
+
+// change t in place, t must not be shared
+void pvec_set_in_place(pvec *const t, size_t idx, var_value value);
+
+void pvec_push_in_place(pvec *const t, var_value value);
+
+// v is unchanged, the new version shares all but the changed path
+pvec *pvec_set(pvec *const v, size_t idx, var_value value);
+
+pvec *pvec_push(pvec *const v, var_value value);
+
+pvec *pvec_from_values(const var_value *const values, size_t len);
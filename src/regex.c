@@ -0,0 +1,693 @@
+#define _GNU_SOURCE
+
+#include "regex.h"
+#include "hash.h"
+
+#define REGEX_LIST_END UINT32_MAX
+
+#define REGEX_DFA_UNKNOWN UINT32_MAX
+
+#define REGEX_DFA_STOP 0x80000000 // set in transitions to unknown states and states that end a scan
+
+extern inline bool regex_set_has(const regex_set *const s, uint8_t b);
+
+const char *regex_status_string(regex_status status) {
+    static const char *statuses[] = {
+        "_START_REGEX_STATUS",
+        "OK",
+        "UNEXPECTED_END",
+        "UNBALANCED_PARENS",
+        "INVALID_CLASS",
+        "INVALID_ESCAPE",
+        "NOTHING_TO_REPEAT",
+        "ANCHOR_NOT_AT_EDGE",
+        "TOO_BIG",
+        "_END_REGEX_STATUS"
+    };
+    return status > REGEX_STATUS_PFX(_START_REGEX_STATUS) && status < REGEX_STATUS_PFX(_END_REGEX_STATUS) ? statuses[status] : "REGEX_STATUS_NOT_FOUND";
+}
+
+static void set_add(regex_set *const s, uint8_t b) {
+    s->bits[b >> 6] |= (uint64_t) 1 << (b & 63);
+}
+
+static void set_add_range(regex_set *const s, uint8_t lo, uint8_t hi) {
+    for (unsigned b = lo; b <= hi; b++) set_add(s, (uint8_t) b);
+}
+
+static void set_invert(regex_set *const s) {
+    for (size_t i = 0; i < 4; i++) s->bits[i] = ~s->bits[i];
+}
+
+static void set_union(regex_set *const dest, const regex_set *const src) {
+    for (size_t i = 0; i < 4; i++) dest->bits[i] |= src->bits[i];
+}
+
+// thompson construction, a fragment leaves its unset outs in a list threaded through the outs themselves
+
+typedef struct {
+    uint32_t start, outs; // list entries are state << 1 | 1 for out1
+} regex_frag;
+
+typedef struct {
+    regex *re;
+    const char *pattern;
+    size_t len, pos;
+    regex_status status;
+} regex_parser;
+
+static uint32_t nfa_add(regex_parser *const p, regex_nfa_type type, uint32_t out, uint32_t out1, uint32_t set) {
+    regex *re = p->re;
+    if (re->num_nfa >= REGEX_MAX_NFA) {
+        p->status = REGEX_STATUS_PFX(TOO_BIG);
+        return 0;
+    }
+    if (re->num_nfa == re->nfa_size) {
+        re->nfa_size *= 2;
+        re->nfa = realloc(re->nfa, sizeof(regex_nfa_state) * re->nfa_size);
+    }
+    re->nfa[re->num_nfa] = (regex_nfa_state) { .type = type, .out = out, .out1 = out1, .set = set };
+    return (uint32_t) re->num_nfa++;
+}
+
+static uint32_t set_new(regex_parser *const p, const regex_set *const s) {
+    regex *re = p->re;
+    if (re->num_sets == re->sets_size) {
+        re->sets_size *= 2;
+        re->sets = realloc(re->sets, sizeof(regex_set) * re->sets_size);
+    }
+    re->sets[re->num_sets] = *s;
+    return (uint32_t) re->num_sets++;
+}
+
+static uint32_t *list_field(regex *const re, uint32_t entry) {
+    regex_nfa_state *s = &re->nfa[entry >> 1];
+    return (entry & 1) ? &s->out1 : &s->out;
+}
+
+static void list_patch(regex *const re, uint32_t list, uint32_t target) {
+    while (list != REGEX_LIST_END) {
+        uint32_t *field = list_field(re, list);
+        list = *field;
+        *field = target;
+    }
+}
+
+static uint32_t list_append(regex *const re, uint32_t first, uint32_t second) {
+    if (first == REGEX_LIST_END) return second;
+    uint32_t last = first;
+    while (*list_field(re, last) != REGEX_LIST_END) last = *list_field(re, last);
+    *list_field(re, last) = second;
+    return first;
+}
+
+static regex_frag frag_bytes(regex_parser *const p, const regex_set *const s) {
+    uint32_t set = set_new(p, s);
+    uint32_t state = nfa_add(p, REGEX_NFA_PFX(BYTES), REGEX_LIST_END, REGEX_LIST_END, set);
+    return (regex_frag) { .start = state, .outs = state << 1 };
+}
+
+static regex_frag frag_byte(regex_parser *const p, uint8_t b) {
+    // literals of the same byte share a set so they do not add classes
+    regex *re = p->re;
+    if (re->single[b] == 0) {
+        regex_set s = { .bits = { 0 } };
+        set_add(&s, b);
+        re->single[b] = set_new(p, &s);
+    }
+    uint32_t state = nfa_add(p, REGEX_NFA_PFX(BYTES), REGEX_LIST_END, REGEX_LIST_END, re->single[b]);
+    return (regex_frag) { .start = state, .outs = state << 1 };
+}
+
+static bool class_escape(char c, regex_set *const s) {
+    // adds the bytes of \d \w \s and their inverses
+    regex_set tmp = { .bits = { 0 } };
+    switch (c) {
+        case 'd':
+        case 'D':
+            set_add_range(&tmp, '0', '9');
+            break;
+        case 'w':
+        case 'W':
+            set_add_range(&tmp, '0', '9');
+            set_add_range(&tmp, 'a', 'z');
+            set_add_range(&tmp, 'A', 'Z');
+            set_add(&tmp, '_');
+            break;
+        case 's':
+        case 'S':
+            set_add_range(&tmp, '\t', '\r');
+            set_add(&tmp, ' ');
+            break;
+        default:
+            return false;
+    }
+    if (c == 'D' || c == 'W' || c == 'S') set_invert(&tmp);
+    set_union(s, &tmp);
+    return true;
+}
+
+static bool escape_byte(char c, uint8_t *const b) {
+    switch (c) {
+        case 'n':
+            *b = '\n';
+            return true;
+        case 't':
+            *b = '\t';
+            return true;
+        case 'r':
+            *b = '\r';
+            return true;
+        case '0':
+            *b = '\0';
+            return true;
+        default:
+            break;
+    }
+    // only punctuation escapes to itself so letters stay free for later classes
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return false;
+    *b = (uint8_t) c;
+    return true;
+}
+
+static regex_frag parse_alt(regex_parser *const p);
+
+static regex_frag parse_class(regex_parser *const p) {
+    regex_set s = { .bits = { 0 } };
+    bool negate = p->pos < p->len && p->pattern[p->pos] == '^';
+    if (negate) p->pos++;
+    bool first = true;
+    while (p->pos < p->len && (p->pattern[p->pos] != ']' || first)) {
+        first = false;
+        uint8_t lo = (uint8_t) p->pattern[p->pos++], hi;
+        if (lo == '\\') {
+            if (p->pos >= p->len) break;
+            char c = p->pattern[p->pos++];
+            if (class_escape(c, &s)) continue;
+            if (escape_byte(c, &lo) == false) {
+                p->status = REGEX_STATUS_PFX(INVALID_ESCAPE);
+                return (regex_frag) { 0 };
+            }
+        }
+        hi = lo;
+        if (p->pos + 1 < p->len && p->pattern[p->pos] == '-' && p->pattern[p->pos + 1] != ']') {
+            hi = (uint8_t) p->pattern[p->pos + 1];
+            p->pos += 2;
+            if (hi == '\\') {
+                if (p->pos >= p->len || escape_byte(p->pattern[p->pos++], &hi) == false) {
+                    p->status = REGEX_STATUS_PFX(INVALID_ESCAPE);
+                    return (regex_frag) { 0 };
+                }
+            }
+            if (hi < lo) {
+                p->status = REGEX_STATUS_PFX(INVALID_CLASS);
+                return (regex_frag) { 0 };
+            }
+        }
+        set_add_range(&s, lo, hi);
+    }
+    if (p->pos >= p->len) {
+        p->status = REGEX_STATUS_PFX(UNEXPECTED_END);
+        return (regex_frag) { 0 };
+    }
+    p->pos++;
+    if (negate) set_invert(&s);
+    return frag_bytes(p, &s);
+}
+
+static regex_frag parse_atom(regex_parser *const p) {
+    regex_set s = { .bits = { 0 } };
+    uint8_t b;
+    char c = p->pattern[p->pos++];
+    switch (c) {
+        case '(': {
+            regex_frag f = parse_alt(p);
+            if (p->status != REGEX_STATUS_PFX(OK)) return f;
+            if (p->pos >= p->len || p->pattern[p->pos] != ')') {
+                p->status = REGEX_STATUS_PFX(UNBALANCED_PARENS);
+                return f;
+            }
+            p->pos++;
+            return f;
+        }
+        case '[':
+            return parse_class(p);
+        case '.':
+            set_add_range(&s, 0, 255);
+            s.bits['\n' >> 6] &= ~((uint64_t) 1 << ('\n' & 63));
+            return frag_bytes(p, &s);
+        case '\\':
+            if (p->pos >= p->len) {
+                p->status = REGEX_STATUS_PFX(UNEXPECTED_END);
+                return (regex_frag) { 0 };
+            }
+            c = p->pattern[p->pos++];
+            if (class_escape(c, &s)) return frag_bytes(p, &s);
+            if (escape_byte(c, &b)) return frag_byte(p, b);
+            p->status = REGEX_STATUS_PFX(INVALID_ESCAPE);
+            return (regex_frag) { 0 };
+        case '*':
+        case '+':
+        case '?':
+            p->status = REGEX_STATUS_PFX(NOTHING_TO_REPEAT);
+            return (regex_frag) { 0 };
+        case '^':
+        case '$':
+            p->status = REGEX_STATUS_PFX(ANCHOR_NOT_AT_EDGE);
+            return (regex_frag) { 0 };
+        default:
+            return frag_byte(p, (uint8_t) c);
+    }
+}
+
+static regex_frag parse_repeat(regex_parser *const p) {
+    regex_frag f = parse_atom(p);
+    while (p->status == REGEX_STATUS_PFX(OK) && p->pos < p->len) {
+        char c = p->pattern[p->pos];
+        if (c != '*' && c != '+' && c != '?') break;
+        p->pos++;
+        uint32_t split = nfa_add(p, REGEX_NFA_PFX(SPLIT), f.start, REGEX_LIST_END, 0);
+        if (p->status != REGEX_STATUS_PFX(OK)) break;
+        if (c == '*') {
+            list_patch(p->re, f.outs, split);
+            f = (regex_frag) { .start = split, .outs = split << 1 | 1 };
+        } else if (c == '+') {
+            list_patch(p->re, f.outs, split);
+            f.outs = split << 1 | 1;
+        } else {
+            f = (regex_frag) { .start = split, .outs = list_append(p->re, f.outs, split << 1 | 1) };
+        }
+    }
+    return f;
+}
+
+static regex_frag parse_concat(regex_parser *const p) {
+    regex_frag f = { .start = REGEX_LIST_END, .outs = REGEX_LIST_END };
+    while (p->status == REGEX_STATUS_PFX(OK) && p->pos < p->len && p->pattern[p->pos] != '|' && p->pattern[p->pos] != ')') {
+        regex_frag g = parse_repeat(p);
+        if (p->status != REGEX_STATUS_PFX(OK)) return f;
+        if (f.start == REGEX_LIST_END) {
+            f = g;
+            continue;
+        }
+        list_patch(p->re, f.outs, g.start);
+        f.outs = g.outs;
+    }
+    if (f.start == REGEX_LIST_END) {
+        uint32_t empty = nfa_add(p, REGEX_NFA_PFX(EMPTY), REGEX_LIST_END, REGEX_LIST_END, 0);
+        f = (regex_frag) { .start = empty, .outs = empty << 1 };
+    }
+    return f;
+}
+
+static regex_frag parse_alt(regex_parser *const p) {
+    regex_frag f = parse_concat(p);
+    while (p->status == REGEX_STATUS_PFX(OK) && p->pos < p->len && p->pattern[p->pos] == '|') {
+        p->pos++;
+        regex_frag g = parse_concat(p);
+        if (p->status != REGEX_STATUS_PFX(OK)) break;
+        uint32_t split = nfa_add(p, REGEX_NFA_PFX(SPLIT), f.start, g.start, 0);
+        f = (regex_frag) { .start = split, .outs = list_append(p->re, f.outs, g.outs) };
+    }
+    return f;
+}
+
+static void find_prefix(regex *const re, const char *const pattern, size_t len) {
+    // any top level alternation means no single prefix
+    size_t depth = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (pattern[i] == '\\') {
+            i++;
+        } else if (pattern[i] == '[') {
+            while (++i < len && pattern[i] != ']') if (pattern[i] == '\\') i++;
+        } else if (pattern[i] == '(') {
+            depth++;
+        } else if (pattern[i] == ')') {
+            depth--;
+        } else if (pattern[i] == '|' && depth == 0) {
+            return;
+        }
+    }
+    re->prefix = malloc(len + 1);
+    for (size_t i = 0; i < len;) {
+        uint8_t b = (uint8_t) pattern[i];
+        size_t width = 1;
+        if (strchr("([.*+?|)", b) != NULL) break;
+        if (b == '\\') {
+            if (i + 1 >= len || escape_byte(pattern[i + 1], &b) == false) break;
+            width = 2;
+        }
+        // an optional byte ends the prefix, a repeated one is still needed once
+        size_t q = i + width;
+        bool optional = false;
+        for (; q < len && strchr("*+?", pattern[q]) != NULL; q++) if (pattern[q] != '+') optional = true;
+        if (optional) break;
+        re->prefix[re->prefix_len++] = (char) b;
+        if (q > i + width) break;
+        i += width;
+    }
+}
+
+static void find_classes(regex *const re) {
+    // split classes until every set holds either all or none of each class
+    memset(re->classes, 0, sizeof(re->classes));
+    re->num_classes = 1;
+    uint16_t remap[512];
+    for (size_t i = 0; i < re->num_sets; i++) {
+        memset(remap, 0xFF, sizeof(uint16_t) * re->num_classes * 2);
+        size_t num = 0;
+        for (unsigned b = 0; b < 256; b++) {
+            size_t key = re->classes[b] * 2 + regex_set_has(&re->sets[i], (uint8_t) b);
+            if (remap[key] == 0xFFFF) remap[key] = (uint16_t) num++;
+            re->classes[b] = (uint8_t) remap[key];
+        }
+        re->num_classes = num;
+    }
+    for (unsigned b = 256; b-- > 0;) re->reps[re->classes[b]] = (uint8_t) b;
+}
+
+static void dfa_init(regex *const re) {
+    // half the cache for transitions half for the nfa states of each dfa state
+    size_t row = sizeof(uint32_t) * re->num_classes + sizeof(regex_dfa_state);
+    re->dfa_max = REGEX_DFA_CACHE_SIZE / 2 / row;
+    if (re->dfa_max < 8) re->dfa_max = 8;
+    re->arena_size = REGEX_DFA_CACHE_SIZE / 2 / sizeof(uint32_t);
+    if (re->arena_size < re->num_nfa * 2) re->arena_size = re->num_nfa * 2;
+    size_t table_size = 16;
+    while (table_size < re->dfa_max * 2) table_size *= 2;
+    re->table_mask = table_size - 1;
+    re->dfa = malloc(sizeof(regex_dfa_state) * re->dfa_max);
+    re->trans = malloc(sizeof(uint32_t) * re->num_classes * re->dfa_max);
+    re->arena = malloc(sizeof(uint32_t) * re->arena_size);
+    re->table = calloc(table_size, sizeof(uint32_t));
+    re->dfa_start = REGEX_DFA_UNKNOWN;
+    re->marks = calloc(re->num_nfa, sizeof(uint32_t));
+    re->stack = malloc(sizeof(uint32_t) * re->num_nfa);
+    re->cur = malloc(sizeof(uint32_t) * re->num_nfa);
+    re->next = malloc(sizeof(uint32_t) * re->num_nfa);
+}
+
+regex_status regex_compile(regex **const out, const char *const pattern, size_t len) {
+    regex *re = calloc(1, sizeof(regex));
+    regex_parser p = { .re = re, .pattern = pattern, .len = len, .pos = 0, .status = REGEX_STATUS_PFX(OK) };
+    re->nfa_size = 16;
+    re->nfa = malloc(sizeof(regex_nfa_state) * re->nfa_size);
+    re->sets_size = 16;
+    re->sets = malloc(sizeof(regex_set) * re->sets_size);
+    // set 0 is every byte for the unanchored loop
+    regex_set any;
+    memset(&any, 0xFF, sizeof(any));
+    set_new(&p, &any);
+    if (p.len > 0 && pattern[0] == '^') {
+        re->anchored_start = true;
+        p.pos = 1;
+    }
+    if (p.len > p.pos && pattern[p.len - 1] == '$') {
+        size_t slashes = 0;
+        while (p.len - 1 - slashes > p.pos && pattern[p.len - 2 - slashes] == '\\') slashes++;
+        if (slashes % 2 == 0) {
+            re->anchored_end = true;
+            p.len--;
+        }
+    }
+    regex_frag f = parse_alt(&p);
+    if (p.status == REGEX_STATUS_PFX(OK) && p.pos < p.len) p.status = REGEX_STATUS_PFX(UNBALANCED_PARENS);
+    if (p.status == REGEX_STATUS_PFX(OK)) list_patch(re, f.outs, nfa_add(&p, REGEX_NFA_PFX(MATCH), REGEX_LIST_END, REGEX_LIST_END, 0));
+    re->start = f.start;
+    if (p.status == REGEX_STATUS_PFX(OK) && re->anchored_start == false) {
+        // a match can start at any byte
+        uint32_t loop = nfa_add(&p, REGEX_NFA_PFX(SPLIT), f.start, REGEX_LIST_END, 0);
+        uint32_t any_byte = nfa_add(&p, REGEX_NFA_PFX(BYTES), loop, REGEX_LIST_END, 0);
+        if (p.status == REGEX_STATUS_PFX(OK)) re->nfa[loop].out1 = any_byte;
+        re->start = loop;
+    }
+    if (p.status != REGEX_STATUS_PFX(OK)) {
+        regex_free(re);
+        *out = NULL;
+        return p.status;
+    }
+    size_t skip = re->anchored_start ? 1 : 0;
+    find_prefix(re, pattern + skip, p.len - skip);
+    find_classes(re);
+    dfa_init(re);
+    *out = re;
+    return REGEX_STATUS_PFX(OK);
+}
+
+void regex_free(regex *re) {
+    free(re->nfa);
+    free(re->sets);
+    free(re->prefix);
+    free(re->dfa);
+    free(re->trans);
+    free(re->arena);
+    free(re->table);
+    free(re->marks);
+    free(re->stack);
+    free(re->cur);
+    free(re->next);
+    free(re);
+}
+
+// sets of nfa states, each state is added once per step by its mark
+
+static void next_gen(regex *const re) {
+    if (++re->gen == 0) {
+        memset(re->marks, 0, sizeof(uint32_t) * re->num_nfa);
+        re->gen = 1;
+    }
+}
+
+static void closure(regex *const re, uint32_t id, uint32_t *const set, size_t *const len, bool *const match) {
+    size_t top = 0;
+    if (re->marks[id] == re->gen) return;
+    re->marks[id] = re->gen;
+    re->stack[top++] = id;
+    while (top > 0) {
+        const regex_nfa_state *s = &re->nfa[re->stack[--top]];
+        switch (s->type) {
+            case REGEX_NFA_PFX(SPLIT):
+                if (re->marks[s->out1] != re->gen) {
+                    re->marks[s->out1] = re->gen;
+                    re->stack[top++] = s->out1;
+                }
+                // fall through
+            case REGEX_NFA_PFX(EMPTY):
+                if (re->marks[s->out] != re->gen) {
+                    re->marks[s->out] = re->gen;
+                    re->stack[top++] = s->out;
+                }
+                break;
+            case REGEX_NFA_PFX(MATCH):
+                *match = true;
+                // fall through
+            case REGEX_NFA_PFX(BYTES):
+                set[(*len)++] = (uint32_t) (s - re->nfa);
+                break;
+        }
+    }
+}
+
+static size_t step(regex *const re, const uint32_t *const in, size_t in_len, uint8_t b, uint32_t *const out, bool *const match) {
+    size_t len = 0;
+    *match = false;
+    next_gen(re);
+    for (size_t i = 0; i < in_len; i++) {
+        const regex_nfa_state *s = &re->nfa[in[i]];
+        if (s->type == REGEX_NFA_PFX(BYTES) && regex_set_has(&re->sets[s->set], b)) closure(re, s->out, out, &len, match);
+    }
+    return len;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+static void dfa_flush(regex *const re) {
+    re->dfa_len = 0;
+    re->arena_len = 0;
+    re->dfa_start = REGEX_DFA_UNKNOWN;
+    re->flushes++;
+    memset(re->table, 0, sizeof(uint32_t) * (re->table_mask + 1));
+}
+
+static uint32_t dfa_intern(regex *const re, uint32_t *const set, size_t len, bool match) {
+    // unknown if the cache is full
+    qsort(set, len, sizeof(uint32_t), cmp_u32);
+    size_t i = hash_key((const char*) set, sizeof(uint32_t) * len) & re->table_mask;
+    for (; re->table[i] != 0; i = (i + 1) & re->table_mask) {
+        const regex_dfa_state *d = &re->dfa[re->table[i] - 1];
+        if (d->len == len && memcmp(re->arena + d->set, set, sizeof(uint32_t) * len) == 0) return re->table[i] - 1;
+    }
+    if (re->dfa_len == re->dfa_max || re->arena_len + len > re->arena_size) return REGEX_DFA_UNKNOWN;
+    uint32_t idx = (uint32_t) re->dfa_len++;
+    re->dfa[idx] = (regex_dfa_state) { .set = (uint32_t) re->arena_len, .len = (uint32_t) len, .match = match };
+    memcpy(re->arena + re->arena_len, set, sizeof(uint32_t) * len);
+    re->arena_len += len;
+    memset(re->trans + idx * re->num_classes, 0xFF, sizeof(uint32_t) * re->num_classes);
+    re->table[i] = idx + 1;
+    return idx;
+}
+
+typedef struct {
+    uint32_t state; // dfa state, unknown once running the nfa
+    size_t cur_len, flushes;
+    bool match, dead;
+} regex_scan;
+
+static void scan_begin(regex *const re, regex_scan *const scan) {
+    scan->flushes = 0;
+    scan->dead = false;
+    if (re->dfa_start == REGEX_DFA_UNKNOWN) {
+        size_t len = 0;
+        bool match = false;
+        next_gen(re);
+        closure(re, re->start, re->next, &len, &match);
+        if ((re->dfa_start = dfa_intern(re, re->next, len, match)) == REGEX_DFA_UNKNOWN) {
+            dfa_flush(re);
+            re->dfa_start = dfa_intern(re, re->next, len, match);
+        }
+    }
+    scan->state = re->dfa_start;
+    scan->match = re->dfa[scan->state].match;
+}
+
+static bool dfa_stop(const regex *const re, uint32_t state) {
+    // nothing after a match or a dead state changes the result
+    return (re->dfa[state].match && re->anchored_end == false) || re->dfa[state].len == 0;
+}
+
+static uint32_t dfa_miss(regex *const re, regex_scan *const scan, uint8_t b) {
+    const regex_dfa_state *d = &re->dfa[scan->state];
+    bool match;
+    size_t len = step(re, re->arena + d->set, d->len, b, re->next, &match);
+    uint32_t next = dfa_intern(re, re->next, len, match);
+    if (next != REGEX_DFA_UNKNOWN) {
+        // transitions hold the row of the next state so the scan loop does not multiply
+        re->trans[scan->state * re->num_classes + re->classes[b]] = next * re->num_classes | (dfa_stop(re, next) ? REGEX_DFA_STOP : 0);
+        return next;
+    }
+    dfa_flush(re);
+    if (++scan->flushes > REGEX_DFA_MAX_FLUSHES) {
+        // the cache thrashes, the nfa keeps the time linear without it
+        memcpy(re->cur, re->next, sizeof(uint32_t) * len);
+        scan->cur_len = len;
+        scan->match = match;
+        scan->dead = len == 0;
+        scan->state = REGEX_DFA_UNKNOWN;
+        return REGEX_DFA_UNKNOWN;
+    }
+    return dfa_intern(re, re->next, len, match);
+}
+
+static bool scan_feed(regex *const re, regex_scan *const scan, const uint8_t *data, size_t len) {
+    // false once nothing more can change the result
+    size_t i = 0;
+    if (scan->state != REGEX_DFA_UNKNOWN) {
+        const size_t num_classes = re->num_classes;
+        const uint32_t *const trans = re->trans;
+        uint32_t row = scan->state * num_classes;
+        if (dfa_stop(re, scan->state) == false) {
+            for (; i < len; i++) {
+                uint32_t next = trans[row + re->classes[data[i]]];
+                if ((next & REGEX_DFA_STOP) == 0) {
+                    row = next;
+                    continue;
+                }
+                uint32_t state = (next & ~REGEX_DFA_STOP) / num_classes;
+                if (next == REGEX_DFA_UNKNOWN) {
+                    scan->state = row / num_classes;
+                    if ((state = dfa_miss(re, scan, data[i])) == REGEX_DFA_UNKNOWN) {
+                        i++;
+                        break;
+                    }
+                }
+                row = state * num_classes;
+                if (dfa_stop(re, state)) {
+                    i++;
+                    break;
+                }
+            }
+        }
+        if (scan->state != REGEX_DFA_UNKNOWN) {
+            scan->state = row / num_classes;
+            scan->match = re->dfa[scan->state].match;
+            scan->dead = re->dfa[scan->state].len == 0;
+        }
+    }
+    if (scan->state == REGEX_DFA_UNKNOWN) {
+        for (; i < len && scan->dead == false && (scan->match == false || re->anchored_end); i++) {
+            bool match;
+            scan->cur_len = step(re, re->cur, scan->cur_len, data[i], re->next, &match);
+            uint32_t *tmp = re->cur;
+            re->cur = re->next;
+            re->next = tmp;
+            scan->match = match;
+            scan->dead = scan->cur_len == 0;
+        }
+    }
+    return scan->dead == false && (scan->match == false || re->anchored_end);
+}
+
+bool regex_match(regex *const re, const char *const data, size_t len) {
+    size_t start = 0;
+    if (re->prefix_len > 0) {
+        if (re->anchored_start) {
+            if (len < re->prefix_len || memcmp(data, re->prefix, re->prefix_len) != 0) return false;
+        } else {
+            // no match can start before the first place the prefix is
+            const char *found = memmem(data, len, re->prefix, re->prefix_len);
+            if (found == NULL) return false;
+            start = found - data;
+        }
+    }
+    regex_scan scan;
+    scan_begin(re, &scan);
+    scan_feed(re, &scan, (const uint8_t*) data + start, len - start);
+    return scan.match;
+}
+
+typedef struct {
+    regex *re;
+    regex_scan scan;
+} regex_rope_scan;
+
+static bool rope_leaf_feed(void *arg, const char *bytes, size_t len) {
+    regex_rope_scan *rs = arg;
+    return scan_feed(rs->re, &rs->scan, (const uint8_t*) bytes, len);
+}
+
+bool regex_match_rope(regex *const re, const rope *const r) {
+    // flatten does not change a leaf
+    if (r->type != ROPE_PFX(CONCAT)) return regex_match(re, rope_flatten((rope*) r), r->len);
+    regex_rope_scan rs = { .re = re };
+    scan_begin(re, &rs.scan);
+    rope_each_leaf(r, rope_leaf_feed, &rs);
+    return rs.scan.match;
+}
+
+bool regex_next_line(regex *const re, const char *const data, size_t len, size_t *const pos, size_t *const line_start, size_t *const line_end) {
+    while (*pos < len) {
+        size_t start = *pos;
+        if (re->prefix_len > 0 && re->anchored_start == false) {
+            // skip every line without the prefix in one scan
+            const char *found = memmem(data + start, len - start, re->prefix, re->prefix_len);
+            if (found == NULL) {
+                *pos = len;
+                return false;
+            }
+            const char *nl = memrchr(data + start, '\n', found - (data + start));
+            if (nl != NULL) start = nl + 1 - data;
+        }
+        const char *nl = memchr(data + start, '\n', len - start);
+        size_t end = nl != NULL ? (size_t) (nl - data) : len;
+        *pos = end + 1;
+        if (regex_match(re, data + start, end - start)) {
+            *line_start = start;
+            *line_end = end;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "def.h"
+#include "rope.h"
+
+#define REGEX_STATUS_PFX(NAME) REGEX_STATUS_##NAME
+
+typedef enum {
+    REGEX_STATUS_PFX(_START_REGEX_STATUS),
+    REGEX_STATUS_PFX(OK),
+    REGEX_STATUS_PFX(UNEXPECTED_END),
+    REGEX_STATUS_PFX(UNBALANCED_PARENS),
+    REGEX_STATUS_PFX(INVALID_CLASS),
+    REGEX_STATUS_PFX(INVALID_ESCAPE),
+    REGEX_STATUS_PFX(NOTHING_TO_REPEAT),
+    REGEX_STATUS_PFX(ANCHOR_NOT_AT_EDGE),
+    REGEX_STATUS_PFX(TOO_BIG),
+    REGEX_STATUS_PFX(_END_REGEX_STATUS)
+} regex_status;
+
+const char *regex_status_string(regex_status status);
+
+#define REGEX_NFA_PFX(NAME) REGEX_NFA_##NAME
+
+typedef enum {
+    REGEX_NFA_PFX(BYTES), // takes a byte in set to out
+    REGEX_NFA_PFX(SPLIT), // out and out1 without a byte
+    REGEX_NFA_PFX(EMPTY), // out without a byte
+    REGEX_NFA_PFX(MATCH)
+} regex_nfa_type;
+
+typedef struct {
+    regex_nfa_type type;
+    uint32_t out, out1, set;
+} regex_nfa_state;
+
+typedef struct {
+    uint64_t bits[4];
+} regex_set;
+
+inline bool regex_set_has(const regex_set *const s, uint8_t b) {
+    return (s->bits[b >> 6] >> (b & 63)) & 1;
+}
+
+typedef struct {
+    uint32_t set, len; // nfa states in the arena, a dead state has none
+    bool match;
+} regex_dfa_state;
+
+typedef struct _regex {
+    // anchors apply to the whole pattern
+    bool anchored_start, anchored_end;
+    uint32_t start;
+    size_t num_nfa, nfa_size, num_sets, sets_size;
+    regex_nfa_state *nfa;
+    regex_set *sets;
+    uint32_t single[256]; // set of each literal byte, 0 if not made yet
+    size_t num_classes; // bytes no set tells apart share a class
+    uint8_t classes[256], reps[256];
+    size_t prefix_len; // literal every match starts with, found with memmem
+    char *prefix;
+    // dfa states are made on first use and all dropped when the cache is full
+    size_t dfa_len, dfa_max, arena_len, arena_size, table_mask, flushes;
+    regex_dfa_state *dfa;
+    uint32_t *trans, *arena, *table, dfa_start;
+    // scratch for building sets
+    uint32_t gen, *marks, *stack, *cur, *next;
+} regex;
+
+regex_status regex_compile(regex **const re, const char *const pattern, size_t len);
+
+void regex_free(regex *re);
+
+// a regex is used by one thread at a time, matching fills its dfa cache
+
+bool regex_match(regex *const re, const char *const data, size_t len); // anywhere in data unless anchored
+
+bool regex_match_rope(regex *const re, const rope *const r); // leaves are scanned in place
+
+// finds the next line from pos with a match, pos moves past it
+bool regex_next_line(regex *const re, const char *const data, size_t len, size_t *const pos, size_t *const line_start, size_t *const line_end);
@@ -0,0 +1,48 @@
+#include "region.h"
+
+static region_chunk *chunk_get(size_t size) {
+    // chunks are REGION_CHUNK_SIZE with the header unless one allocation needs more
+    size_t bytes = sizeof(region_chunk) + size;
+    if (bytes < REGION_CHUNK_SIZE) bytes = REGION_CHUNK_SIZE;
+    region_chunk *c = slab_alloc(bytes);
+    if (c == NULL) return NULL;
+    c->size = bytes - sizeof(region_chunk);
+    return c;
+}
+
+static void region_push(region *const r, region_chunk *const c) {
+    c->next = r->head;
+    r->head = c;
+    r->cur = (uint8_t*) (c + 1);
+    r->end = r->cur + c->size;
+}
+
+void *region_init(region *const r, size_t size) {
+    r->head = NULL;
+    region_chunk *c = chunk_get(size);
+    if (c == NULL) return NULL;
+    region_push(r, c);
+    void *owner = r->cur;
+    r->cur += (size + 15) & ~(size_t) 15;
+    return owner;
+}
+
+extern inline void *region_alloc(region *const r, size_t size, size_t align);
+
+void *region_alloc_slow(region *const r, size_t size, size_t align) {
+    // the rest of the current chunk is left unused
+    region_chunk *c = chunk_get(size + align);
+    if (c == NULL) return NULL;
+    region_push(r, c);
+    return region_alloc(r, size, align);
+}
+
+void region_release(region *const r) {
+    // r can be inside the first chunk so it is not read after that chunk is freed
+    region_chunk *c = r->head;
+    while (c != NULL) {
+        region_chunk *next = c->next;
+        slab_free(c, sizeof(region_chunk) + c->size);
+        c = next;
+    }
+}
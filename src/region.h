@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "def.h"
+#include "slab.h"
+
+typedef struct _region_chunk {
+    struct _region_chunk *next;
+    size_t size; // bytes after the header
+} region_chunk;
+
+// bump allocation from a list of chunks, nothing is freed until the whole region is
+typedef struct {
+    region_chunk *head; // the chunk being filled, older chunks follow
+    uint8_t *cur, *end;
+} region;
+
+// returns size bytes at the start of the first chunk for the owner, the owner can hold the region there
+void *region_init(region *const r, size_t size);
+
+void *region_alloc_slow(region *const r, size_t size, size_t align);
+
+inline void *region_alloc(region *const r, size_t size, size_t align) {
+    // align is a power of 2
+    uintptr_t p = ((uintptr_t) r->cur + align - 1) & ~(uintptr_t) (align - 1);
+    if (p + size > (uintptr_t) r->end) return region_alloc_slow(r, size, align);
+    r->cur = (uint8_t*) (p + size);
+    return (void*) p;
+}
+
+// frees every chunk including the one given by init
+void region_release(region *const r);
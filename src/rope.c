@@ -0,0 +1,231 @@
+
+#include "rope.h"
+
+extern inline rope *rope_from_string(const string *const s);
+
+extern inline rope *rope_copy(rope *const r);
+
+static rope *rope_init(rope_type type, size_t len) {
+    rope *r = slab_alloc(sizeof(rope));
+    memset(r, 0, sizeof(rope));
+    atomic_init(&r->refs, 1);
+    r->type = type;
+    r->len = len;
+    return r;
+}
+
+rope *rope_from_buffer(const char *const buffer, size_t len) {
+    if (len <= ROPE_SMALL_LEN) {
+        rope *r = rope_init(ROPE_PFX(SMALL), len);
+        memcpy(r->small, buffer, len);
+        return r;
+    }
+    rope *r = rope_init(ROPE_PFX(FLAT), len);
+    r->flat = string_init(len);
+    memcpy(r->flat->buffer, buffer, len);
+    r->flat->len = len;
+    return r;
+}
+
+rope *rope_from_file(int fd) {
+    size_t len;
+    const char *bytes = file_map(fd, &len);
+    if (bytes != NULL) {
+        rope *r = rope_init(ROPE_PFX(MAPPED), len);
+        r->mapped = bytes;
+        return r;
+    }
+    string *s = file_read_to_string(fd);
+    if (s == NULL) return NULL;
+    rope *r = rope_init(ROPE_PFX(FLAT), s->len);
+    r->flat = s;
+    return r;
+}
+
+static void rope_free_body(rope *const r) {
+    if (r->type == ROPE_PFX(FLAT)) {
+        string_free(r->flat);
+    } else if (r->type == ROPE_PFX(MAPPED)) {
+        file_unmap(r->mapped, r->len);
+    } else if (r->type == ROPE_PFX(CONCAT)) {
+        rope_free(r->concat.left);
+        rope_free(r->concat.right);
+    }
+}
+
+void rope_free(rope *r) {
+    if (atomic_fetch_sub(&r->refs, 1) > 1) return;
+    rope_free_body(r);
+    slab_free(r, sizeof(rope));
+}
+
+void rope_copy_bytes(const rope *const r, char *const dest) {
+    switch (r->type) {
+        case ROPE_PFX(SMALL):
+            memcpy(dest, r->small, r->len);
+            break;
+        case ROPE_PFX(FLAT):
+            memcpy(dest, r->flat->buffer, r->len);
+            break;
+        case ROPE_PFX(MAPPED):
+            memcpy(dest, r->mapped, r->len);
+            break;
+        case ROPE_PFX(CONCAT):
+            rope_copy_bytes(r->concat.left, dest);
+            rope_copy_bytes(r->concat.right, dest + r->concat.left->len);
+            break;
+    }
+}
+
+static bool rope_is_buffer(const rope *const r) {
+    return r->type == ROPE_PFX(SMALL) || r->type == ROPE_PFX(FLAT);
+}
+
+static rope *rope_node(rope *const left, rope *const right) {
+    rope *r = rope_init(ROPE_PFX(CONCAT), left->len + right->len);
+    r->concat.left = left;
+    r->concat.right = right;
+    r->depth = (left->depth > right->depth ? left->depth : right->depth) + 1;
+    return r;
+}
+
+static void rope_expose(rope *const r, rope **const left, rope **const right) {
+    // nodes can be shared so the sides are copied out before r is dropped
+    *left = rope_copy(r->concat.left);
+    *right = rope_copy(r->concat.right);
+    rope_free(r);
+}
+
+static rope *rope_rotate_left(rope *const r) {
+    // (a (b c)) to ((a b) c)
+    rope *a, *bc, *b, *c;
+    rope_expose(r, &a, &bc);
+    rope_expose(bc, &b, &c);
+    return rope_node(rope_node(a, b), c);
+}
+
+static rope *rope_rotate_right(rope *const r) {
+    // ((a b) c) to (a (b c))
+    rope *ab, *a, *b, *c;
+    rope_expose(r, &ab, &c);
+    rope_expose(ab, &a, &b);
+    return rope_node(a, rope_node(b, c));
+}
+
+static rope *rope_merge(rope *const left, rope *const right) {
+    // short pieces are copied into one leaf so appends do not add a node each
+    if (rope_is_buffer(left) == false || rope_is_buffer(right) == false || left->len + right->len > ROPE_LEAF_LEN) return rope_node(left, right);
+    rope *r = rope_init(ROPE_PFX(FLAT), left->len + right->len);
+    r->flat = string_init(r->len);
+    rope_copy_bytes(left, r->flat->buffer);
+    rope_copy_bytes(right, r->flat->buffer + left->len);
+    r->flat->len = r->len;
+    rope_free(left);
+    rope_free(right);
+    return r;
+}
+
+static rope *rope_join_right(rope *const left, rope *const right) {
+    // left is deeper by more than one, right goes down its right side and rotations keep the sides within one
+    rope *l, *c, *joined;
+    rope_expose(left, &l, &c);
+    bool base = c->depth <= right->depth + 1;
+    joined = base == true ? rope_merge(c, right) : rope_join_right(c, right);
+    if (joined->depth <= l->depth + 1) return rope_node(l, joined);
+    if (base == true) return rope_rotate_left(rope_node(l, rope_rotate_right(joined)));
+    return rope_rotate_left(rope_node(l, joined));
+}
+
+static rope *rope_join_left(rope *const left, rope *const right) {
+    rope *c, *r, *joined;
+    rope_expose(right, &c, &r);
+    bool base = c->depth <= left->depth + 1;
+    joined = base == true ? rope_merge(left, c) : rope_join_left(left, c);
+    if (joined->depth <= r->depth + 1) return rope_node(joined, r);
+    if (base == true) return rope_rotate_right(rope_node(rope_rotate_left(joined), r));
+    return rope_rotate_right(rope_node(joined, r));
+}
+
+rope *rope_concat(rope *const left, rope *const right) {
+    if (left->len == 0) {
+        rope_free(left);
+        return right;
+    }
+    if (right->len == 0) {
+        rope_free(right);
+        return left;
+    }
+    if (left->len + right->len <= ROPE_SMALL_LEN) {
+        rope *r = rope_init(ROPE_PFX(SMALL), left->len + right->len);
+        rope_copy_bytes(left, r->small);
+        rope_copy_bytes(right, r->small + left->len);
+        rope_free(left);
+        rope_free(right);
+        return r;
+    }
+    // the sides of every concat differ in depth by at most one so depth stays logarithmic in the leaves
+    if (left->depth > right->depth + 1) return rope_join_right(left, right);
+    if (right->depth > left->depth + 1) return rope_join_left(left, right);
+    return rope_merge(left, right);
+}
+
+const char *rope_flatten(rope *const r) {
+    if (r->type == ROPE_PFX(SMALL)) return r->small;
+    if (r->type == ROPE_PFX(MAPPED)) return r->mapped;
+    if (r->type == ROPE_PFX(CONCAT)) {
+        string *flat = string_init(r->len);
+        rope_copy_bytes(r, flat->buffer);
+        flat->len = r->len;
+        rope_free_body(r);
+        r->type = ROPE_PFX(FLAT);
+        r->flat = flat;
+        r->depth = 0;
+    }
+    return r->flat->buffer;
+}
+
+static const char *leaf_bytes(const rope *const r) {
+    if (r->type == ROPE_PFX(SMALL)) return r->small;
+    if (r->type == ROPE_PFX(MAPPED)) return r->mapped;
+    return r->flat->buffer;
+}
+
+bool rope_write(int fd, const rope *const r) {
+    struct iovec iov[ROPE_WRITE_IOV];
+    const rope *stack[ROPE_MAX_DEPTH + 1];
+    int count = 0;
+    size_t top = 0;
+    stack[top++] = r;
+    while (top > 0) {
+        const rope *cur = stack[--top];
+        if (cur->type == ROPE_PFX(CONCAT)) {
+            stack[top++] = cur->concat.right;
+            stack[top++] = cur->concat.left;
+            continue;
+        }
+        if (cur->len == 0) continue;
+        iov[count].iov_base = (void*) leaf_bytes(cur);
+        iov[count++].iov_len = cur->len;
+        if (count == ROPE_WRITE_IOV) {
+            if (file_write_iov(fd, iov, count) == false) return false;
+            count = 0;
+        }
+    }
+    return file_write_iov(fd, iov, count);
+}
+
+bool rope_each_leaf(const rope *const r, bool (*fn)(void *arg, const char *bytes, size_t len), void *arg) {
+    const rope *stack[ROPE_MAX_DEPTH + 1];
+    size_t top = 0;
+    stack[top++] = r;
+    while (top > 0) {
+        const rope *cur = stack[--top];
+        if (cur->type == ROPE_PFX(CONCAT)) {
+            stack[top++] = cur->concat.right;
+            stack[top++] = cur->concat.left;
+            continue;
+        }
+        if (cur->len > 0 && fn(arg, leaf_bytes(cur), cur->len) == false) return false;
+    }
+    return true;
+}
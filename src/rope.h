@@ -0,0 +1,59 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "string.h"
+#include "def.h"
+#include "slab.h"
+#include "file.h"
+
+#define ROPE_PFX(NAME) ROPE_##NAME
+
+typedef enum {
+    ROPE_PFX(SMALL), // bytes are in the node
+    ROPE_PFX(FLAT),
+    ROPE_PFX(MAPPED), // read only view of a file
+    ROPE_PFX(CONCAT)
+} rope_type;
+
+typedef struct _rope {
+    atomic_size_t refs; // concats share their sides
+    rope_type type;
+    size_t len, depth; // depth is 0 for leaves
+    union {
+        char small[ROPE_SMALL_LEN];
+        string *flat;
+        const char *mapped;
+        struct {
+            struct _rope *left, *right;
+        } concat;
+    };
+} rope;
+
+rope *rope_from_buffer(const char *const buffer, size_t len);
+
+rope *rope_from_file(int fd); // mapped if it can be, otherwise read, null on error
+
+inline rope *rope_from_string(const string *const s) {
+    return rope_from_buffer(s->buffer, s->len);
+}
+
+inline rope *rope_copy(rope *const r) {
+    atomic_fetch_add(&r->refs, 1);
+    return r;
+}
+
+void rope_free(rope *r);
+
+rope *rope_concat(rope *const left, rope *const right); // takes the refs to both sides
+
+void rope_copy_bytes(const rope *const r, char *const dest); // dest needs len bytes
+
+const char *rope_flatten(rope *const r); // turns a concat into one leaf, not safe if another thread reads r
+
+bool rope_write(int fd, const rope *const r); // leaves are written with writev without flattening
+
+// calls fn on the bytes of each leaf in order until it returns false, false if it stopped early
+bool rope_each_leaf(const rope *const r, bool (*fn)(void *arg, const char *bytes, size_t len), void *arg);
@@ -0,0 +1,810 @@
+
+#include "run.h"
+
+const char *run_status_string(run_status status) {
+    static const char *statuses[] = {
+        "_START_RUN",
+        "OK",
+        "WRITE_FAIL",
+        "VEC_LEN_MISMATCH",
+        "STACK_OVERFLOW",
+        "_END_RUN"
+    };
+    return status > RUN_STATUS_PFX(_START_RUN) && status < RUN_STATUS_PFX(_END_RUN) ? statuses[status] : "RUN_STATUS_NOT_FOUND";
+}
+
+run_state *run_state_init(infer_state *const ins) {
+    run_state *state = calloc(1, sizeof(run_state));
+    state->ins = ins;
+    atomic_init(&state->status, RUN_STATUS_PFX(OK));
+    state->io = aio_init(AIO_DEPTH);
+    fork_mark(ins->p->root_fn);
+    fuse_mark(ins->p->root_fn);
+    capture_mark(ins->p->root_fn, NULL);
+    branch_mark(ins->p->root_fn, NULL);
+    escape_mark(ins->p->root_fn, NULL);
+    own_mark(ins->p->root_fn, NULL);
+    size_t num_workers = pool_default_num_workers();
+    if (num_workers > 1) {
+        state->p = pool_init(num_workers);
+        // enough tasks to keep every worker busy, deeper calls are too small to be worth a task
+        for (size_t n = 1; n < num_workers; n *= 2) state->fork_depth++;
+        state->fork_depth += RUN_FORK_EXTRA_DEPTH;
+    }
+    return state;
+}
+
+void run_state_free(run_state *state) {
+    for (size_t i = 0; i < OUT_MAX_FDS; i++) if (state->outs[i] != NULL) out_buf_free(state->outs[i]);
+    for (size_t i = 0; i < state->num_coros; i++) ir_coro_free(state->coros[i]);
+    free(state->coros);
+    aio_free(state->io);
+    if (state->threads != NULL && state->threads != state->p) pool_free(state->threads);
+    if (state->p != NULL) pool_free(state->p);
+    infer_state_free(state->ins);
+    free(state);
+}
+
+static bool run_ok(run_state *const state) {
+    return atomic_load_explicit(&state->status, memory_order_relaxed) == RUN_STATUS_PFX(OK);
+}
+
+static void run_fail(run_state *const state, run_status status) {
+    // workers can fail at once, only the first error is kept
+    run_status ok = RUN_STATUS_PFX(OK);
+    atomic_compare_exchange_strong(&state->status, &ok, status);
+}
+
+run_frame *run_frame_init(stack *const s, const ast_fn_node *const fn, size_t depth) {
+    // a call is a push of the args and locals sized by the parser and the env
+    size_t num_slots = fn->type->body.fn->num_args + fn->type->body.fn->num_locals;
+    size_t size = (sizeof(run_frame) + sizeof(var_data) * num_slots + sizeof(var_data*) * fn->num_captures + 15) & ~(size_t) 15;
+    run_frame *frame = stack_push(s, size);
+    frame->fn = fn;
+    frame->depth = depth;
+    frame->s = s;
+    frame->r = (region) { .head = NULL };
+    frame->locals = frame->slots;
+    frame->env = (var_data**) (frame->slots + num_slots);
+    memset(frame->slots, 0, sizeof(var_data) * num_slots);
+    return frame;
+}
+
+static void run_frame_view(run_frame *const view, stack *const s, const run_frame *const frame) {
+    // reads and writes the locals of frame, calls from it go on s so another thread can run them
+    *view = *frame;
+    view->s = s;
+    view->r = (region) { .head = NULL };
+}
+
+void run_frame_free(run_frame *frame) {
+    // vecs in locals are owned by the frame, a view only owns its region
+    if (frame->locals != frame->slots) {
+        region_release(&frame->r);
+        return;
+    }
+    const symbol_table *symbols = frame->fn->type->body.fn->symbols;
+    for (size_t i = 0; i < symbols->size; i++) {
+        for (const symbol_table_bucket *b = symbols->buckets[i]; b != NULL; b = b->next)
+            if (b->type != NULL && b->type->header == VAR_PFX(VEC)) vec_free(frame->locals[b->idx.stack].v);
+    }
+    region_release(&frame->r);
+    stack_pop(frame->s, frame);
+}
+
+static var_data *ref_lookup(run_frame *const frame, ast_ref ref) {
+    return ref.env == true ? frame->env[ref.idx] : &frame->locals[ref.idx];
+}
+
+static var_data *var_lookup(run_frame *const frame, const ast_node *const var) {
+    return ref_lookup(frame, var->ref);
+}
+
+static var_closure *run_closure(run_frame *const frame, const ast_fn_node *const fn) {
+    // the env points at the slots of the frame making the fn so assigns through it are seen by the frame
+    if (fn->lifted != NULL) return fn->lifted;
+    var_closure *c = region_alloc(&frame->r, sizeof(var_closure) + sizeof(var_data*) * fn->num_captures, 16);
+    c->fn = fn;
+    for (size_t i = 0; i < fn->num_captures; i++) c->env[i] = ref_lookup(frame, fn->refs[i]);
+    return c;
+}
+
+static var_type_header node_header(const ast_node *const node) {
+    var_type type;
+    if (get_type_from_node(node, &type) == false) return VAR_PFX(UNKNOWN);
+    return type.header;
+}
+
+static bool node_fresh_vec(const ast_node *const node) {
+    // every vec not read from a var is a new vec owned by whoever uses it
+    return node->type != AST_PFX(VAR) && node_header(node) == VAR_PFX(VEC);
+}
+
+static void drop_fresh_vec(const ast_node *const node, var_data data) {
+    if (node_fresh_vec(node) == true) vec_free(data.v);
+}
+
+static var_data run_node_owned(run_state *const state, run_frame *const frame, const ast_node *const node) {
+    // a vec read from a var gets a new ref unless the read moves it out of the frame
+    if (node->type != AST_PFX(VAR) || node_header(node) != VAR_PFX(VEC)) return run_node(state, frame, node);
+    var_data *local = var_lookup(frame, node), data = *local;
+    if (node->move == true) local->v = NULL;
+    else data.v = vec_retain(data.v);
+    return data;
+}
+
+static bool write_data(out_buf *const o, const var_type *const type, var_data data) {
+    size_t len = 0;
+    if (type == NULL) return true;
+    if (type->header == VAR_PFX(VEC)) {
+        // packed vecs are written space separated
+        if (data.v == NULL) return true;
+        var_type item_type = { .header = data.v->header };
+        for (size_t i = 0; i < data.v->len; i++) {
+            var_data item = { .u64 = 0 };
+            memcpy(&item, vec_get(data.v, i), data.v->item_size);
+            if (i > 0 && out_buf_write(o, " ", 1) == false) return false;
+            if (write_data(o, &item_type, item) == false) return false;
+        }
+        return true;
+    }
+    if (var_type_is_float(type->header)) return out_buf_f64(o, var_data_to_f64(type->header, data));
+    if (var_type_is_unsgined(type->header)) return out_buf_u64(o, var_data_to_u64(type->header, data));
+    if (var_type_is_signed(type->header)) return out_buf_i64(o, (int64_t) var_data_to_u64(type->header, data));
+    if (type->header == VAR_PFX(CHAR)) {
+        while (len < 4 && data.c.c[len] != '\0') len++;
+        return out_buf_write(o, (const char*) data.c.c, len);
+    }
+    if (type->header == VAR_PFX(STRING)) return out_buf_rope(o, data.str);
+    // the rest of the file is moved in the kernel after what was buffered
+    if (type->header == VAR_PFX(FD)) return out_buf_sync(o) && file_transfer(o->fd, data.fd);
+    return true;
+}
+
+typedef struct {
+    pool_task task;
+    run_state *state;
+    run_frame *frame;
+    const ast_node *node;
+    var_data ret;
+} run_fork;
+
+static void run_fork_task(void *arg) {
+    // the stack gets its first segment only if the node makes a call
+    run_fork *f = arg;
+    stack s;
+    run_frame view;
+    stack_init(&s);
+    run_frame_view(&view, &s, f->frame);
+    f->ret = run_node(f->state, &view, f->node);
+    run_frame_free(&view);
+    stack_release(&s);
+}
+
+static void run_fork_start(run_state *const state, run_frame *const frame, run_fork *const f, const ast_node *const node) {
+    f->state = state;
+    f->frame = frame;
+    f->node = node;
+    pool_task_setup(&f->task, run_fork_task, f);
+    pool_fork(state->p, &f->task);
+}
+
+static bool run_can_fork(const run_state *const state, const run_frame *const frame) {
+    return state->p != NULL && frame->depth <= state->fork_depth;
+}
+
+static var_data run_list(run_state *const state, run_frame *const frame, ast_node_link *head) {
+    // the last value is returned the rest are dropped
+    var_data ret = { .u64 = 0 };
+    for (; head != NULL; head = head->next) {
+        if (head->node == NULL) continue;
+        if (head->next == NULL || head->next->node == NULL) return run_node_owned(state, frame, head->node);
+        drop_fresh_vec(head->node, run_node(state, frame, head->node));
+    }
+    return ret;
+}
+
+static var_data run_vec(run_state *const state, run_frame *const frame, const ast_vec_node *const vec_node) {
+    // only vecs with one item type exist at run time, others are written item by item
+    if (vec_node->type->body.vec->dynamic == NULL) return (var_data) { .v = NULL };
+    if (vec_node->alloc == AST_ALLOC_PFX(NONE)) {
+        // the vec is dropped so only the items are run
+        for (ast_node_link *head = vec_node->items_head; head != NULL; head = head->next)
+            if (head->node != NULL) drop_fresh_vec(head->node, run_node(state, frame, head->node));
+        return (var_data) { .v = NULL };
+    }
+    vec *v = vec_init_region(vec_node->alloc == AST_ALLOC_PFX(FRAME) ? &frame->r : NULL, vec_node->type->body.vec->dynamic->header, vec_node->num_items);
+    for (ast_node_link *head = vec_node->items_head; head != NULL; head = head->next) {
+        if (head->node == NULL) continue;
+        var_data item = run_node(state, frame, head->node);
+        vec_push(&v, &item);
+    }
+    return (var_data) { .v = v };
+}
+
+static const vec_op vec_ops[] = {
+    [AST_PFX(ADD)] = VEC_OP_PFX(ADD),
+    [AST_PFX(SUB)] = VEC_OP_PFX(SUB),
+    [AST_PFX(EQUAL)] = VEC_OP_PFX(EQUAL),
+    [AST_PFX(LESSEQUAL)] = VEC_OP_PFX(LESSEQUAL)
+};
+
+static var_type_header item_header(const ast_node *const node) {
+    var_type type;
+    if (get_type_from_node(node, &type) == false) return VAR_PFX(UNKNOWN);
+    if (type.header == VAR_PFX(VEC)) return type.body.vec->dynamic->header;
+    return type.header;
+}
+
+typedef struct {
+    size_t num_leaves, num_ops, leaf_idx, buf_idx, buf_len; // buf_len items in each chunk
+    const ast_node **nodes; // leaves in the order they are run
+    var_data *leaves;
+    uint8_t *bufs; // a chunk for each op
+} run_fuse;
+
+static void fuse_count(const ast_node *const node, run_fuse *const f) {
+    if (fuse_is_vec_op(node) == false) {
+        f->num_leaves++;
+        return;
+    }
+    f->num_ops++;
+    fuse_count(node->data.op->left, f);
+    fuse_count(node->data.op->right, f);
+}
+
+static void fuse_leaves(run_state *const state, run_frame *const frame, run_fuse *const f, const ast_node *const node) {
+    if (fuse_is_vec_op(node) == false) {
+        f->nodes[f->leaf_idx] = node;
+        f->leaves[f->leaf_idx++] = run_node(state, frame, node);
+        return;
+    }
+    fuse_leaves(state, frame, f, node->data.op->left);
+    fuse_leaves(state, frame, f, node->data.op->right);
+}
+
+static const void *fuse_chunk(run_fuse *const f, const ast_node *const node, size_t start, size_t len, bool *const scalar, void *const dest) {
+    // returns len items of node starting at start, leaf vecs are read in place
+    if (fuse_is_vec_op(node) == false) {
+        var_data *leaf = &f->leaves[f->leaf_idx++];
+        *scalar = node_header(node) != VAR_PFX(VEC);
+        return *scalar == true ? (const void*) leaf : vec_get(leaf->v, start);
+    }
+    bool left_scalar, right_scalar;
+    const void *left = fuse_chunk(f, node->data.op->left, start, len, &left_scalar, NULL);
+    const void *right = fuse_chunk(f, node->data.op->right, start, len, &right_scalar, NULL);
+    void *out = dest != NULL ? dest : f->bufs + f->buf_idx++ * f->buf_len * sizeof(uint64_t);
+    vec_op_items(vec_ops[node->type], item_header(node->data.op->left), len, left, left_scalar, right, right_scalar, out);
+    *scalar = false;
+    return out;
+}
+
+static void fuse_range(run_fuse *const f, const ast_node *const node, vec *const out, size_t start, size_t end) {
+    bool scalar;
+    for (; start < end; start += RUN_FUSE_CHUNK) {
+        f->leaf_idx = f->buf_idx = 0;
+        fuse_chunk(f, node, start, end - start < RUN_FUSE_CHUNK ? end - start : RUN_FUSE_CHUNK, &scalar, vec_get(out, start));
+    }
+}
+
+typedef struct {
+    const run_fuse *f;
+    const ast_node *node;
+    vec *out;
+} run_fuse_range;
+
+static void fuse_range_task(void *arg, size_t start, size_t end) {
+    // leaves are shared read only, each range gets its own chunk bufs
+    run_fuse_range *r = arg;
+    run_fuse f = *r->f;
+    f.bufs = slab_alloc(f.num_ops * f.buf_len * sizeof(uint64_t));
+    fuse_range(&f, r->node, r->out, start, end);
+    slab_free(f.bufs, f.num_ops * f.buf_len * sizeof(uint64_t));
+}
+
+static vec *fuse_reuse(const run_fuse *const f, const ast_node *const leaf, var_type_header header, size_t len) {
+    // the vec of the leaf is written in place when nothing else holds it
+    for (size_t i = 0; leaf != NULL && i < f->num_leaves; i++) {
+        if (f->nodes[i] != leaf) continue;
+        vec *v = f->leaves[i].v;
+        if (v->header == header && v->len == len && vec_unique(v) == true) return vec_retain(v);
+    }
+    return NULL;
+}
+
+static vec *run_fused(run_state *const state, run_frame *const frame, const ast_node *const node, out_buf *const o) {
+    // a chain of vec ops is run chunk by chunk so only the result is allocated
+    // if o is not null the chunks are written and nothing is allocated
+    // scratch space is in the region when the frame is not shared with another thread
+    region *r = node->data.op->alloc == AST_ALLOC_PFX(FRAME) ? &frame->r : NULL;
+    run_fuse f = { .num_leaves = 0 };
+    fuse_count(node, &f);
+    if (r != NULL) {
+        f.nodes = region_alloc(r, f.num_leaves * sizeof(ast_node*), _Alignof(ast_node*));
+        f.leaves = region_alloc(r, f.num_leaves * sizeof(var_data), _Alignof(var_data));
+    } else {
+        f.nodes = slab_alloc(f.num_leaves * sizeof(ast_node*));
+        f.leaves = slab_alloc(f.num_leaves * sizeof(var_data));
+    }
+    fuse_leaves(state, frame, &f, node);
+    size_t len = SIZE_MAX;
+    bool mismatch = false;
+    for (size_t i = 0; i < f.num_leaves; i++) {
+        if (node_header(f.nodes[i]) != VAR_PFX(VEC)) continue;
+        if (len != SIZE_MAX && len != f.leaves[i].v->len) mismatch = true;
+        if (f.leaves[i].v->len < len) len = f.leaves[i].v->len;
+    }
+    if (mismatch == true) run_fail(state, RUN_STATUS_PFX(VEC_LEN_MISMATCH));
+    // a failed op gives an empty vec rather than a truncated one, a failed call in the leaves writes nothing
+    if (run_ok(state) == false) len = 0;
+    // short vecs only need chunks as long as they are so small ops fit in the region
+    f.buf_len = len < RUN_FUSE_CHUNK ? (len > 0 ? len : 1) : RUN_FUSE_CHUNK;
+    size_t bufs_size = (f.num_ops * f.buf_len * sizeof(uint64_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    f.bufs = r != NULL ? region_alloc(r, bufs_size, CACHE_LINE_SIZE) : slab_alloc(bufs_size);
+    var_type item_type = { .header = node->data.op->return_type->body.vec->dynamic->header };
+    vec *out = o == NULL ? fuse_reuse(&f, node->data.op->reuse, item_type.header, len) : NULL;
+    if (o == NULL && out == NULL) {
+        out = vec_init_region(r, item_type.header, len);
+        out->len = len;
+    }
+    if (out != NULL && state->p != NULL && len >= RUN_PARALLEL_MIN_ITEMS) {
+        run_fuse_range r = { .f = &f, .node = node, .out = out };
+        pool_for(state->p, len, RUN_PARALLEL_GRAIN, fuse_range_task, &r);
+    } else if (out != NULL) {
+        fuse_range(&f, node, out, 0, len);
+    }
+    bool scalar, ok = true;
+    for (size_t start = 0; out == NULL && start < len && ok == true; start += RUN_FUSE_CHUNK) {
+        size_t chunk_len = len - start < RUN_FUSE_CHUNK ? len - start : RUN_FUSE_CHUNK;
+        f.leaf_idx = f.buf_idx = 0;
+        const uint8_t *items = fuse_chunk(&f, node, start, chunk_len, &scalar, NULL);
+        size_t item_size = vec_item_size(item_type.header);
+        for (size_t i = 0; i < chunk_len && ok == true; i++) {
+            var_data item = { .u64 = 0 };
+            memcpy(&item, items + i * item_size, item_size);
+            if (start + i > 0) ok = out_buf_write(o, " ", 1);
+            if (ok == true) ok = write_data(o, &item_type, item);
+        }
+    }
+    if (ok == false) run_fail(state, RUN_STATUS_PFX(WRITE_FAIL));
+    for (size_t i = 0; i < f.num_leaves; i++) drop_fresh_vec(f.nodes[i], f.leaves[i]);
+    if (r == NULL) {
+        slab_free(f.nodes, f.num_leaves * sizeof(ast_node*));
+        slab_free(f.leaves, f.num_leaves * sizeof(var_data));
+        slab_free(f.bufs, bufs_size);
+    }
+    return out;
+}
+
+static var_data run_vec_op(run_state *const state, run_frame *const frame, const ast_node *const node) {
+    // with a pool large vecs are split across the workers by the fused path
+    if (node->data.op->fuse == true || state->p != NULL) return (var_data) { .v = run_fused(state, frame, node, NULL) };
+    const ast_node *left_node = node->data.op->left, *right_node = node->data.op->right;
+    var_data left = run_node(state, frame, left_node), right = run_node(state, frame, right_node), ret;
+    region *r = node->data.op->alloc == AST_ALLOC_PFX(FRAME) ? &frame->r : NULL;
+    bool left_vec = node_header(left_node) == VAR_PFX(VEC), right_vec = node_header(right_node) == VAR_PFX(VEC);
+    vec *in_place = NULL;
+    if (node->data.op->reuse == left_node && left_vec == true) in_place = left.v;
+    else if (node->data.op->reuse == right_node && right_vec == true) in_place = right.v;
+    if (in_place != NULL && (left_vec == false || right_vec == false || left.v->len == right.v->len) && vec_unique(in_place) == true) {
+        // the var being assigned has the only ref so the result goes in its items
+        vec_op_items(vec_ops[node->type], in_place->header, in_place->len, left_vec == true ? (const void*) left.v->items : &left, left_vec == false,
+            right_vec == true ? (const void*) right.v->items : &right, right_vec == false, in_place->items);
+        ret.v = vec_retain(in_place);
+    } else if (left_vec == true && right_vec == true && left.v->len != right.v->len) {
+        run_fail(state, RUN_STATUS_PFX(VEC_LEN_MISMATCH));
+        ret.v = vec_init_region(r, node->data.op->return_type->body.vec->dynamic->header, 0);
+    } else if (left_vec == true && right_vec == true) {
+        ret.v = vec_op_vec(r, vec_ops[node->type], left.v, right.v);
+    } else if (left_vec == true) {
+        ret.v = vec_op_scalar(r, vec_ops[node->type], left.v, &right, false);
+    } else {
+        ret.v = vec_op_scalar(r, vec_ops[node->type], right.v, &left, true);
+    }
+    drop_fresh_vec(left_node, left);
+    drop_fresh_vec(right_node, right);
+    return ret;
+}
+
+static out_buf *run_out(run_state *const state, int fd) {
+    // fds past OUT_MAX_FDS get a buffer for one write
+    if (fd < 0 || fd >= OUT_MAX_FDS) return out_buf_init(fd, NULL);
+    if (state->outs[fd] == NULL) state->outs[fd] = out_buf_init(fd, state->io);
+    return state->outs[fd];
+}
+
+static out_buf *run_write_out(run_state *const state, run_frame *const frame, const ast_op_node *const op) {
+    // returns the buffer of the fd, null for fds without one
+    // nothing is written once the run has failed
+    var_type type;
+    if (run_ok(state) == false) return NULL;
+    var_data data = run_node(state, frame, op->left);
+    int fd = node_header(op->left) == VAR_PFX(I64) ? (int) data.i64 : data.fd;
+    out_buf *o = run_out(state, fd);
+    bool ok = true;
+    if (op->right->type == AST_PFX(VEC) && op->right->data.vec->type->body.vec->dynamic == NULL) {
+        // mixed items are gathered in the buffer of the fd, packed vecs print like any other vec
+        ast_node_link *head = op->right->data.vec->items_head;
+        for (size_t i = 0; head != NULL && ok == true && run_ok(state) == true; head = head->next) {
+            if (head->node == NULL) continue;
+            if (fuse_is_vec_op(head->node) == true && head->node->data.op->fuse == true) {
+                // streamed without building the vec
+                run_fused(state, frame, head->node, o);
+                i++;
+                continue;
+            }
+            data = run_node(state, frame, head->node);
+            if (run_ok(state) == true) ok = write_data(o, op->right->data.vec->type->body.vec->items[i++], data);
+            drop_fresh_vec(head->node, data);
+        }
+    } else if (fuse_is_vec_op(op->right) == true && op->right->data.op->fuse == true) {
+        run_fused(state, frame, op->right, o);
+    } else {
+        data = run_node(state, frame, op->right);
+        if (run_ok(state) == true && get_type_from_node(op->right, &type) == true) ok = write_data(o, &type, data);
+        drop_fresh_vec(op->right, data);
+    }
+    if (fd < 0 || fd >= OUT_MAX_FDS) {
+        ok = out_buf_free(o) && ok;
+        o = NULL;
+    }
+    if (ok == false) run_fail(state, RUN_STATUS_PFX(WRITE_FAIL));
+    return o;
+}
+
+static var_data run_write(run_state *const state, run_frame *const frame, const ast_op_node *const op) {
+    run_write_out(state, frame, op);
+    return (var_data) { .u64 = 0 };
+}
+
+static const ast_fn_node *run_call_fn(run_frame *const frame, const ast_call_node *const call) {
+    return call->target != NULL ? call->target : var_lookup(frame, call->func)->fn->fn;
+}
+
+static run_frame *run_call_frame(run_state *const state, stack *const s, run_frame *const frame, const ast_call_node *const call) {
+    // the callee is pushed on s before the args run, calls in the args are pushed after it
+    const ast_fn_node *fn;
+    run_frame *callee;
+    if (call->target != NULL) {
+        // the env of a known fn is copied from the caller
+        fn = call->target;
+        callee = run_frame_init(s, fn, frame->depth + 1);
+        for (size_t i = 0; i < fn->num_captures; i++) callee->env[i] = ref_lookup(frame, call->env[i]);
+    } else {
+        var_closure *c = var_lookup(frame, call->func)->fn;
+        fn = c->fn;
+        callee = run_frame_init(s, fn, frame->depth + 1);
+        callee->env = c->env;
+    }
+    if (call->fork == true && run_can_fork(state, frame)) {
+        // last arg runs on this thread
+        run_fork forks[AST_MAX_ARGS];
+        for (size_t i = 0; i + 1 < call->num_args; i++) run_fork_start(state, frame, &forks[i], call->args[i]);
+        callee->locals[fn->type->body.fn->args[call->num_args - 1]->idx.stack] = run_node(state, frame, call->args[call->num_args - 1]);
+        for (size_t i = call->num_args - 1; i-- > 0;) {
+            pool_join(state->p, &forks[i].task);
+            callee->locals[fn->type->body.fn->args[i]->idx.stack] = forks[i].ret;
+        }
+    } else {
+        for (size_t i = 0; i < call->num_args; i++)
+            callee->locals[fn->type->body.fn->args[i]->idx.stack] = run_node(state, frame, call->args[i]);
+    }
+    return callee;
+}
+
+static var_data run_call_fail(run_state *const state, const ast_call_node *const call) {
+    // once the run has failed calls are not made, a vec result is empty so the caller can still drop it
+    // the type is read from the node as a closure made by a call that was not made is null
+    run_fail(state, RUN_STATUS_PFX(STACK_OVERFLOW));
+    const var_type *type = call->func->data.var->type->body.fn->return_type;
+    if (type->header == VAR_PFX(VEC) && type->body.vec->dynamic != NULL) return (var_data) { .v = vec_init(type->body.vec->dynamic->header, 0) };
+    return (var_data) { .u64 = 0 };
+}
+
+static var_data run_call(run_state *const state, run_frame *const frame, const ast_call_node *const call) {
+    if (run_ok(state) == false || stack_native_full() == true) return run_call_fail(state, call);
+    run_frame *callee = run_call_frame(state, frame->s, frame, call);
+    var_data ret = run_list(state, callee, callee->fn->body_head);
+    run_frame_free(callee);
+    return ret;
+}
+
+typedef struct {
+    run_state *state;
+    stack s; // the green thread calls on its own stack
+    run_frame *callee;
+} run_thread;
+
+static var_data run_thread_fn(void *arg) {
+    run_thread *rt = arg;
+    var_data ret = run_list(rt->state, rt->callee, rt->callee->fn->body_head);
+    run_frame_free(rt->callee);
+    stack_release(&rt->s);
+    slab_free(rt, sizeof(run_thread));
+    return ret;
+}
+
+var_data run_spawn(run_state *const state, run_frame *const frame, const ast_call_node *const call) {
+    if (state->threads == NULL) state->threads = state->p != NULL ? state->p : pool_init(1);
+    run_thread *rt = slab_alloc(sizeof(run_thread));
+    rt->state = state;
+    stack_init(&rt->s);
+    // args are evaluated before the spawn, the body runs on the green thread
+    rt->callee = run_call_frame(state, &rt->s, frame, call);
+    thread *t = thread_spawn(state->threads, rt->callee->fn->type->body.fn->return_type, run_thread_fn, rt);
+    if (t == NULL) {
+        // no stack left, run it now
+        t = slab_alloc(sizeof(thread));
+        memset(t, 0, sizeof(thread));
+        t->type = rt->callee->fn->type->body.fn->return_type;
+        t->result = run_thread_fn(rt);
+        atomic_init(&t->state, THREAD_STATE_PFX(DONE));
+    }
+    return (var_data) { .t = t };
+}
+
+var_data run_join(var_data data) {
+    var_data ret = thread_join(data.t);
+    thread_free(data.t);
+    return ret;
+}
+
+static ir_coro *run_coro_of(run_state *const state, const ast_fn_node *const fn) {
+    for (size_t i = 0; i < state->num_coros; i++) if (state->coros[i]->fn == fn) return state->coros[i];
+    ir_coro *c = ir_coro_lower(fn);
+    if (c == NULL) return NULL;
+    state->coros = realloc(state->coros, sizeof(ir_coro*) * (state->num_coros + 1));
+    state->coros[state->num_coros++] = c;
+    return c;
+}
+
+static var_type_header local_header(const run_frame *const frame, size_t stack_idx) {
+    const symbol_table *symbols = frame->fn->type->body.fn->symbols;
+    for (size_t i = 0; i < symbols->size; i++) {
+        for (const symbol_table_bucket *b = symbols->buckets[i]; b != NULL; b = b->next)
+            if (b->idx.stack == stack_idx && b->type != NULL) return b->type->header;
+    }
+    return VAR_PFX(UNKNOWN);
+}
+
+static void run_coro_save(ir_coro_frame *const f, run_frame *const scratch) {
+    // only what the next state reads is kept, the rest goes with the scratch frame
+    // vecs in a region are moved to the heap, the args can be in the region of the caller
+    const ir_coro_state *s = &f->coro->states[f->state];
+    for (size_t i = 0; i < s->num_live; i++) {
+        if (local_header(scratch, s->live[i]) == VAR_PFX(VEC)) scratch->locals[s->live[i]].v = vec_promote(scratch->locals[s->live[i]].v);
+        f->slots[i] = scratch->locals[s->live[i]];
+        scratch->locals[s->live[i]].u64 = 0;
+    }
+    run_frame_free(scratch);
+}
+
+static run_frame *run_coro_load(stack *const st, ir_coro_frame *const f) {
+    const ir_coro_state *s = &f->coro->states[f->state];
+    run_frame *scratch = run_frame_init(st, f->coro->fn, 1);
+    scratch->env = f->env;
+    for (size_t i = 0; i < s->num_live; i++) scratch->locals[s->live[i]] = f->slots[i];
+    return scratch;
+}
+
+ir_coro_frame *run_async(run_state *const state, run_frame *const frame, const ast_call_node *const call) {
+    ir_coro *c = run_coro_of(state, run_call_fn(frame, call));
+    if (c == NULL) return NULL;
+    ir_coro_frame *f = ir_coro_frame_alloc(c);
+    if (f == NULL) return NULL;
+    run_frame *callee = run_call_frame(state, frame->s, frame, call);
+    memcpy(f->env, callee->env, sizeof(var_data*) * c->fn->num_captures);
+    run_coro_save(f, callee);
+    return f;
+}
+
+static bool run_coro_resume(run_state *const state, stack *const s, ir_coro_frame *const f) {
+    // true once the coroutine returned, another coroutine can have refilled the buffer it waited on
+    if (f->wait != NULL && out_buf_busy(f->wait)) return false;
+    run_frame *scratch = run_coro_load(s, f);
+    f->wait = NULL;
+    for (;;) {
+        const ir_coro_state *st = &f->coro->states[f->state];
+        out_buf *o = NULL;
+        var_data ret = { .u64 = 0 };
+        for (ast_node_link *head = st->resume; head != NULL; head = head->next) {
+            if (head->node == NULL) continue;
+            if (head->node == st->suspend) {
+                o = run_write_out(state, scratch, head->node->data.op);
+                break;
+            }
+            if (head->next == NULL || head->next->node == NULL) ret = run_node_owned(state, scratch, head->node);
+            else drop_fresh_vec(head->node, run_node(state, scratch, head->node));
+        }
+        if (st->suspend == NULL) {
+            f->ret = ret;
+            run_frame_free(scratch);
+            return true;
+        }
+        f->state++;
+        // small writes gather in the buffer, half full it goes out or the coroutine waits for room
+        if (o == NULL || o->io == NULL || o->len < OUT_BUF_SIZE / 2) continue;
+        if (out_buf_busy(o) == true) {
+            f->wait = o;
+            run_coro_save(f, scratch);
+            return false;
+        }
+        if (out_buf_flush(o) == false) run_fail(state, RUN_STATUS_PFX(WRITE_FAIL));
+    }
+}
+
+void run_await(run_state *const state, ir_coro_frame **const frames, size_t len, var_data *const rets) {
+    ir_coro_frame *ready = NULL, **ready_tail = &ready, *waiting = NULL;
+    stack s;
+    stack_init(&s);
+    for (size_t i = 0; i < len; i++) {
+        *ready_tail = frames[i];
+        ready_tail = &frames[i]->next;
+    }
+    *ready_tail = NULL;
+    while (ready != NULL || waiting != NULL) {
+        while (ready != NULL) {
+            ir_coro_frame *f = ready;
+            ready = f->next;
+            if (run_coro_resume(state, &s, f) == true) continue;
+            f->next = waiting;
+            waiting = f;
+        }
+        if (waiting == NULL) break;
+        aio_poll(state->io, true);
+        ir_coro_frame **w = &waiting;
+        while (*w != NULL) {
+            ir_coro_frame *f = *w;
+            if (out_buf_busy(f->wait)) {
+                w = &f->next;
+                continue;
+            }
+            *w = f->next;
+            f->next = ready;
+            ready = f;
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        rets[i] = frames[i]->ret;
+        ir_coro_frame_free(frames[i]->coro, frames[i]);
+    }
+    stack_release(&s);
+}
+
+static size_t branch_arm(const ast_branch *const b, uint64_t key) {
+    if (b->kind == AST_BRANCH_PFX(TABLE)) {
+        if (key < b->base) return b->arms[0];
+        if (key - b->base >= b->table_len) return b->arms[b->num_ranges - 1];
+        return b->table[key - b->base];
+    }
+    // the last range starting at or before key
+    size_t lo = 0, hi = b->num_ranges;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (b->starts[mid] <= key) lo = mid;
+        else hi = mid;
+    }
+    return b->arms[lo];
+}
+
+static var_data run_if(run_state *const state, run_frame *const frame, const ast_if_node *const if_node) {
+    const ast_branch *b = if_node->branch;
+    if (b != NULL && b->kind != AST_BRANCH_PFX(LINEAR)) {
+        // the operand is read once and the arm found from its key
+        size_t arm = branch_arm(b, var_data_to_u64(b->header, run_node(state, frame, b->operand)) ^ b->flip);
+        if (b->select == true) return b->values[arm];
+        return run_list(state, frame, arm < b->num_arms ? b->conds[arm]->body_head : if_node->else_head);
+    }
+    for (ast_if_cond *c = if_node->conds_head; c != NULL; c = c->next)
+        if (var_data_to_u64(node_header(c->cond), run_node(state, frame, c->cond)) != 0) return run_list(state, frame, c->body_head);
+    return run_list(state, frame, if_node->else_head);
+}
+
+var_data run_node(run_state *const state, run_frame *const frame, const ast_node *const node) {
+    var_data left, right;
+    run_fork f;
+    switch (node->type) {
+        case AST_PFX(VAR):
+            return *var_lookup(frame, node);
+        case AST_PFX(INT):
+            return (var_data) { .i64 = node->data.intv };
+        case AST_PFX(FLOAT):
+            return (var_data) { .f64 = node->data.fv };
+        case AST_PFX(CHAR):
+            return (var_data) { .c = node->data.cv };
+        case AST_PFX(FN):
+            return (var_data) { .fn = run_closure(frame, node->data.fn) };
+        case AST_PFX(CALL):
+            return run_call(state, frame, node->data.call);
+        case AST_PFX(IF):
+            return run_if(state, frame, node->data.ifn);
+        case AST_PFX(VEC):
+            return run_vec(state, frame, node->data.vec);
+        case AST_PFX(ASSIGN):
+            right = run_node_owned(state, frame, node->data.op->right);
+            if (node_header(node->data.op->left) == VAR_PFX(VEC)) {
+                // a var of another fn outlives the region of this frame
+                if (node->data.op->left->ref.env == true) right.v = vec_promote(right.v);
+                vec_free(var_lookup(frame, node->data.op->left)->v);
+            }
+            *var_lookup(frame, node->data.op->left) = right;
+            break;
+        case AST_PFX(CAST):
+            right = run_node(state, frame, node->data.op->right);
+            return var_data_cast(node->data.op->return_type->header, node_header(node->data.op->right), right);
+        case AST_PFX(ADD):
+        case AST_PFX(SUB):
+            if (node->data.op->return_type->header == VAR_PFX(VEC)) return run_vec_op(state, frame, node);
+            if (node->data.op->fork == true && run_can_fork(state, frame)) {
+                run_fork_start(state, frame, &f, node->data.op->left);
+                right = run_node(state, frame, node->data.op->right);
+                pool_join(state->p, &f.task);
+                left = f.ret;
+            } else {
+                left = run_node(state, frame, node->data.op->left);
+                right = run_node(state, frame, node->data.op->right);
+            }
+            if (node->type == AST_PFX(ADD)) return var_data_add(node->data.op->return_type->header, left, right);
+            return var_data_sub(node->data.op->return_type->header, left, right);
+        case AST_PFX(WRITE):
+            return run_write(state, frame, node->data.op);
+        case AST_PFX(EQUAL):
+            if (node->data.op->return_type->header == VAR_PFX(VEC)) return run_vec_op(state, frame, node);
+            left = run_node(state, frame, node->data.op->left);
+            right = run_node(state, frame, node->data.op->right);
+            return var_data_from_u64(VAR_PFX(U8), var_data_equal(node_header(node->data.op->left), left, right));
+        case AST_PFX(LESSEQUAL):
+            if (node->data.op->return_type->header == VAR_PFX(VEC)) return run_vec_op(state, frame, node);
+            left = run_node(state, frame, node->data.op->left);
+            right = run_node(state, frame, node->data.op->right);
+            return var_data_from_u64(VAR_PFX(U8), var_data_less_equal(node_header(node->data.op->left), left, right));
+        default:
+            break;
+    }
+    return (var_data) { .u64 = 0 };
+}
+
+run_status run(run_state *const state) {
+    stack s;
+    stack_init(&s);
+    run_frame *root = run_frame_init(&s, state->ins->p->root_fn, 0);
+    const ast_node *last = NULL;
+    for (ast_node_link *head = state->ins->p->root_fn->body_head; head != NULL; head = head->next)
+        if (head->node != NULL) last = head->node;
+    var_data ret = run_list(state, root, state->ins->p->root_fn->body_head);
+    if (last != NULL && node_header(last) == VAR_PFX(VEC)) vec_free(ret.v);
+    run_frame_free(root);
+    stack_release(&s);
+    // buffered output goes out before the script ends, every fd is in flight at once
+    for (size_t i = 0; i < OUT_MAX_FDS; i++)
+        if (state->outs[i] != NULL && out_buf_flush(state->outs[i]) == false) run_fail(state, RUN_STATUS_PFX(WRITE_FAIL));
+    for (size_t i = 0; i < OUT_MAX_FDS; i++)
+        if (state->outs[i] != NULL && out_buf_sync(state->outs[i]) == false) run_fail(state, RUN_STATUS_PFX(WRITE_FAIL));
+    return atomic_load(&state->status);
+}
+
+typedef struct {
+    infer_state *ins;
+    run_status status;
+} run_main;
+
+static void *run_main_thread(void *arg) {
+    // the pool is made here so this thread is its first worker
+    run_main *m = arg;
+    run_state *state = run_state_init(m->ins);
+    m->status = run(state);
+    run_state_free(state);
+    return NULL;
+}
+
+run_status run_module(infer_state *const ins) {
+    // SC_STACK_MB sizes the stack, only the pages that calls reach are backed, without the thread the main stack is used
+    run_main m = { .ins = ins, .status = RUN_STATUS_PFX(OK) };
+    pthread_attr_t attr;
+    pthread_t t;
+    bool has_attr = pthread_attr_init(&attr) == 0;
+    if (has_attr == true && pthread_attr_setstacksize(&attr, stack_native_size("SC_STACK_MB", RUN_STACK_SIZE)) == 0 && pthread_create(&t, &attr, run_main_thread, &m) == 0) pthread_join(t, NULL);
+    else run_main_thread(&m);
+    if (has_attr == true) pthread_attr_destroy(&attr);
+    return m.status;
+}
@@ -0,0 +1,84 @@
+
+#pragma once
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "infer.h"
+#include "var.h"
+#include "pool.h"
+#include "fork.h"
+#include "fuse.h"
+#include "escape.h"
+#include "own.h"
+#include "capture.h"
+#include "branch.h"
+#include "region.h"
+#include "stack.h"
+#include "out.h"
+#include "thread.h"
+#include "ir.h"
+
+#define RUN_STATUS_PFX(NAME) RUN_STATUS_##NAME
+
+typedef enum {
+    RUN_STATUS_PFX(_START_RUN),
+    RUN_STATUS_PFX(OK),
+    RUN_STATUS_PFX(WRITE_FAIL),
+    RUN_STATUS_PFX(VEC_LEN_MISMATCH),
+    RUN_STATUS_PFX(STACK_OVERFLOW),
+    RUN_STATUS_PFX(_END_RUN)
+} run_status;
+
+const char *run_status_string(run_status status);
+
+typedef struct _run_frame {
+    const ast_fn_node *fn;
+    size_t depth; // number of calls from the module
+    stack *s; // the frame is on it, calls made from the frame are pushed after it
+    region r; // vecs that do not escape the call, no chunk until the first
+    var_data *locals; // indexed by idx.stack of the symbol, slots unless the frame is a view
+    var_data **env; // captured slots, in the frame after the locals or in the closure called
+    var_data slots[]; // args then locals, room for the env follows
+} run_frame;
+
+typedef struct {
+    infer_state *ins;
+    pool *p; // null if single threaded
+    size_t fork_depth; // calls at or below this depth run sequential
+    pool *threads; // green threads, p or a pool made on the first spawn
+    aio *io; // full output buffers are written while the script runs
+    out_buf *outs[OUT_MAX_FDS]; // per fd buffers made on first write, flushed at the end of run
+    size_t num_coros;
+    ir_coro **coros; // lowered on the first async call of each fn
+    _Atomic run_status status; // first error found, set with run_fail
+} run_state;
+
+run_state *run_state_init(infer_state *const ins);
+
+void run_state_free(run_state *state);
+
+// pushed on s with the slots zeroed, the root frame of a module has depth 0
+run_frame *run_frame_init(stack *const s, const ast_fn_node *const fn, size_t depth);
+
+void run_frame_free(run_frame *frame); // frees the vecs the frame owns, then pops it
+
+var_data run_node(run_state *const state, run_frame *const frame, const ast_node *const node);
+
+// the body of the called fn runs on a green thread, the frames it captured from must outlive the join
+var_data run_spawn(run_state *const state, run_frame *const frame, const ast_call_node *const call);
+
+var_data run_join(var_data data); // the result of the spawned fn, frees the thread
+
+// the call runs as a coroutine that suspends at its writes, null if the fn never writes
+// coroutines are only run by the thread that started them, the scratch frame of each resume is on their own stack
+ir_coro_frame *run_async(run_state *const state, run_frame *const frame, const ast_call_node *const call);
+
+// runs the coroutines until all are done, waiting on io only when none can run
+void run_await(run_state *const state, ir_coro_frame **const frames, size_t len, var_data *const rets);
+
+run_status run(run_state *const state);
+
+// inits, runs and frees the state on a thread with a RUN_STACK_SIZE stack, or SC_STACK_MB if set
+// calls fail with STACK_OVERFLOW once less than STACK_NATIVE_MARGIN of the native stack is left,
+// about a million levels of a small fn, fns on green threads only get THREAD_STACK_SIZE
+run_status run_module(infer_state *const ins);
@@ -0,0 +1,243 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include "slab.h"
+
+// under asan every object is its own allocation so bad accesses are still caught
+#ifndef SLAB_BYPASS
+    #if defined(__SANITIZE_ADDRESS__)
+        #define SLAB_BYPASS 1
+    #else
+        #define SLAB_BYPASS 0
+    #endif
+#endif
+
+static const size_t class_sizes[SLAB_NUM_CLASSES] = {
+    16, 32, 48, 64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192
+};
+
+// class of each size past 64 in steps of 64
+static const uint8_t classes_by_64[SLAB_MAX_SIZE / 64 + 1] = {
+    3, 3, 4, 5, 6, 7, 7, 8, 8, 9, 9, 9, 9, 10, 10, 10,
+    10, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12,
+    12, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+    13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+    14, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+    16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+    16
+};
+
+typedef struct _slab_obj {
+    struct _slab_obj *next;
+    struct _slab_obj *next_batch; // only on the first object of a batch in the pool
+} slab_obj;
+
+typedef struct {
+    pthread_mutex_t lock;
+    slab_obj *batches, *loose; // full batches and objects left by threads that exited
+    uint8_t *carve, *carve_end; // unused part of the newest slab
+    size_t slabs, objects;
+    atomic_size_t allocs, frees, requested;
+} slab_class;
+
+typedef struct {
+    slab_obj *head;
+    size_t len;
+    size_t allocs, frees, requested; // since the last trade, requested wraps if more was freed
+} slab_cache;
+
+static slab_class classes[SLAB_NUM_CLASSES] = {
+    [0 ... SLAB_NUM_CLASSES - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static atomic_size_t large = 0, large_bytes = 0;
+
+static _Thread_local slab_cache caches[SLAB_NUM_CLASSES];
+
+static _Thread_local bool cache_key_set = false;
+
+static pthread_key_t cache_key;
+
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+
+static size_t class_of(size_t size) {
+    if (size <= 64) return size > 16 ? (size + 15) / 16 - 1 : 0;
+    return classes_by_64[(size + 63) / 64];
+}
+
+static size_t batch_len(size_t c) {
+    size_t n = SLAB_BATCH_BYTES / class_sizes[c];
+    return n < 2 ? 2 : n > 64 ? 64 : n;
+}
+
+static size_t slab_size(size_t c) {
+    return class_sizes[c] >= SLAB_LARGE_MIN_CLASS ? SLAB_LARGE_SIZE : SLAB_SIZE;
+}
+
+static void cache_flush(slab_class *const sc, slab_cache *const cache) {
+    // called with the lock of the class held
+    atomic_fetch_add_explicit(&sc->allocs, cache->allocs, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sc->frees, cache->frees, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sc->requested, cache->requested, memory_order_relaxed);
+    cache->allocs = cache->frees = cache->requested = 0;
+}
+
+static void cache_free(void *arg) {
+    // objects cached by an exiting thread go back to the pool
+    (void) arg;
+    for (size_t c = 0; c < SLAB_NUM_CLASSES; c++) {
+        slab_class *sc = &classes[c];
+        slab_cache *cache = &caches[c];
+        pthread_mutex_lock(&sc->lock);
+        while (cache->head != NULL) {
+            slab_obj *o = cache->head;
+            cache->head = o->next;
+            o->next = sc->loose;
+            sc->loose = o;
+        }
+        cache->len = 0;
+        cache_flush(sc, cache);
+        pthread_mutex_unlock(&sc->lock);
+    }
+    cache_key_set = false;
+}
+
+static void cache_key_init(void) {
+    pthread_key_create(&cache_key, cache_free);
+}
+
+static void *slab_map(size_t size) {
+    // large slabs are aligned to their size so the kernel can back them with huge pages
+    size_t len = size == SLAB_LARGE_SIZE ? size * 2 : size;
+    uint8_t *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    if (len == size) return p;
+    uint8_t *aligned = (uint8_t*) (((uintptr_t) p + size - 1) & ~(uintptr_t) (size - 1));
+    if (aligned > p) munmap(p, aligned - p);
+    if (aligned + size < p + len) munmap(aligned + size, p + len - (aligned + size));
+#if SLAB_HUGE_PAGES && defined(MADV_HUGEPAGE)
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+static bool cache_refill(slab_cache *const cache, size_t c) {
+    slab_class *sc = &classes[c];
+    size_t want = batch_len(c), size = class_sizes[c];
+    if (cache_key_set == false) {
+        pthread_once(&cache_once, cache_key_init);
+        pthread_setspecific(cache_key, caches);
+        cache_key_set = true;
+    }
+    pthread_mutex_lock(&sc->lock);
+    cache_flush(sc, cache);
+    if (sc->batches != NULL) {
+        cache->head = sc->batches;
+        sc->batches = sc->batches->next_batch;
+        cache->len = want;
+        pthread_mutex_unlock(&sc->lock);
+        return true;
+    }
+    for (; cache->len < want && sc->loose != NULL; cache->len++) {
+        slab_obj *o = sc->loose;
+        sc->loose = o->next;
+        o->next = cache->head;
+        cache->head = o;
+    }
+    for (; cache->len < want; cache->len++) {
+        if (sc->carve == NULL || sc->carve + size > sc->carve_end) {
+            uint8_t *slab = slab_map(slab_size(c));
+            if (slab == NULL) break;
+            sc->carve = slab;
+            sc->carve_end = slab + slab_size(c);
+            sc->slabs++;
+        }
+        slab_obj *o = (slab_obj*) sc->carve;
+        sc->carve += size;
+        sc->objects++;
+        o->next = cache->head;
+        cache->head = o;
+    }
+    pthread_mutex_unlock(&sc->lock);
+    return cache->len > 0;
+}
+
+static void cache_return(slab_cache *const cache, size_t c) {
+    // the first batch of the cache goes to the pool
+    slab_class *sc = &classes[c];
+    size_t want = batch_len(c);
+    slab_obj *batch = cache->head, *last = batch;
+    for (size_t i = 1; i < want; i++) last = last->next;
+    cache->head = last->next;
+    cache->len -= want;
+    last->next = NULL;
+    pthread_mutex_lock(&sc->lock);
+    cache_flush(sc, cache);
+    batch->next_batch = sc->batches;
+    sc->batches = batch;
+    pthread_mutex_unlock(&sc->lock);
+}
+
+static void *large_alloc(size_t size) {
+    size_t rounded = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    void *p = aligned_alloc(CACHE_LINE_SIZE, rounded > 0 ? rounded : CACHE_LINE_SIZE);
+    if (p == NULL) return NULL;
+    atomic_fetch_add_explicit(&large, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&large_bytes, size, memory_order_relaxed);
+    return p;
+}
+
+void *slab_alloc(size_t size) {
+    if (SLAB_BYPASS || size > SLAB_MAX_SIZE) return large_alloc(size);
+    size_t c = class_of(size);
+    slab_cache *cache = &caches[c];
+    if (cache->head == NULL && cache_refill(cache, c) == false) return NULL;
+    slab_obj *o = cache->head;
+    cache->head = o->next;
+    cache->len--;
+    cache->allocs++;
+    cache->requested += size;
+    return o;
+}
+
+void slab_free(void *p, size_t size) {
+    if (p == NULL) return;
+    if (SLAB_BYPASS || size > SLAB_MAX_SIZE) {
+        free(p);
+        atomic_fetch_sub_explicit(&large, 1, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&large_bytes, size, memory_order_relaxed);
+        return;
+    }
+    size_t c = class_of(size);
+    slab_cache *cache = &caches[c];
+    slab_obj *o = p;
+    o->next = cache->head;
+    cache->head = o;
+    cache->len++;
+    cache->frees++;
+    cache->requested -= size;
+    // two batches are kept so a thread going back and forth at the edge does not trade each time
+    if (cache->len >= batch_len(c) * 2) cache_return(cache, c);
+}
+
+void slab_stats_get(slab_stats *const stats) {
+    for (size_t c = 0; c < SLAB_NUM_CLASSES; c++) {
+        slab_class *sc = &classes[c];
+        slab_class_stats *s = &stats->classes[c];
+        pthread_mutex_lock(&sc->lock);
+        cache_flush(sc, &caches[c]);
+        s->size = class_sizes[c];
+        s->slab_size = slab_size(c);
+        s->slabs = sc->slabs;
+        s->objects = sc->objects;
+        s->in_use = atomic_load_explicit(&sc->allocs, memory_order_relaxed) - atomic_load_explicit(&sc->frees, memory_order_relaxed);
+        s->requested = atomic_load_explicit(&sc->requested, memory_order_relaxed);
+        pthread_mutex_unlock(&sc->lock);
+    }
+    stats->large = atomic_load_explicit(&large, memory_order_relaxed);
+    stats->large_bytes = atomic_load_explicit(&large_bytes, memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "def.h"
+
+// size classes up to SLAB_MAX_SIZE, larger sizes go to malloc
+#define SLAB_MAX_SIZE 8192
+
+#define SLAB_NUM_CLASSES 17
+
+// objects are 16 byte aligned and objects of 64 bytes or more are cache line aligned
+// each thread keeps free objects per class and trades them with the shared pool a batch at a time
+void *slab_alloc(size_t size);
+
+void slab_free(void *p, size_t size); // size is what was given to alloc
+
+typedef struct {
+    size_t size, slab_size, slabs, objects; // objects carved from the slabs
+    size_t in_use, requested; // objects not freed and the bytes asked for them
+} slab_class_stats;
+
+typedef struct {
+    slab_class_stats classes[SLAB_NUM_CLASSES];
+    size_t large, large_bytes; // past SLAB_MAX_SIZE
+} slab_stats;
+
+// counts of other threads are added when they trade a batch or exit
+void slab_stats_get(slab_stats *const stats);
@@ -0,0 +1,93 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include "stack.h"
+
+extern inline void stack_init(stack *const s);
+
+_Thread_local uintptr_t stack_native_limit = 0;
+
+static void segment_enter(stack *const s, stack_segment *const seg) {
+    seg->below = s->top;
+    s->seg = seg;
+    s->base = s->top = (uint8_t*) (seg + 1);
+    s->end = s->base + seg->size;
+}
+
+void *stack_push_slow(stack *const s, size_t size) {
+    // each new segment is twice the last so deep recursion links few of them
+    stack_segment *next = s->seg != NULL ? s->seg->next : NULL;
+    if (next != NULL && next->size < size) {
+        slab_free(next, sizeof(stack_segment) + next->size);
+        next = NULL;
+    }
+    if (next == NULL) {
+        size_t bytes = s->seg != NULL ? s->seg->size * 2 : STACK_SEGMENT_SIZE;
+        if (bytes < size) bytes = size;
+        if ((next = slab_alloc(sizeof(stack_segment) + bytes)) == NULL) return NULL;
+        next->size = bytes;
+        next->next = NULL;
+        next->prev = s->seg;
+        if (s->seg != NULL) s->seg->next = next;
+    }
+    segment_enter(s, next);
+    return stack_push(s, size);
+}
+
+extern inline void *stack_push(stack *const s, size_t size);
+
+void stack_pop_slow(stack *const s) {
+    // the segment left stays as next, one after it is freed so a stack going back and forth keeps one spare
+    stack_segment *seg = s->seg, *prev = seg->prev;
+    if (seg->next != NULL) {
+        slab_free(seg->next, sizeof(stack_segment) + seg->next->size);
+        seg->next = NULL;
+    }
+    s->seg = prev;
+    s->base = (uint8_t*) (prev + 1);
+    s->top = seg->below;
+    s->end = s->base + prev->size;
+}
+
+extern inline void stack_pop(stack *const s, void *const p);
+
+void stack_release(stack *const s) {
+    stack_segment *seg = s->seg;
+    while (seg != NULL && seg->prev != NULL) seg = seg->prev;
+    while (seg != NULL) {
+        stack_segment *next = seg->next;
+        slab_free(seg, sizeof(stack_segment) + seg->size);
+        seg = next;
+    }
+    stack_init(s);
+}
+
+uintptr_t stack_native_enter(const void *const low, size_t size) {
+    // small stacks like those of green threads keep an eighth of themselves
+    uintptr_t prev = stack_native_limit;
+    size_t margin = size / 8 < STACK_NATIVE_MARGIN ? size / 8 : STACK_NATIVE_MARGIN;
+    stack_native_limit = (uintptr_t) low + margin;
+    return prev;
+}
+
+void stack_native_leave(uintptr_t prev) {
+    stack_native_limit = prev;
+}
+
+void stack_native_find(void) {
+    pthread_attr_t attr;
+    void *low;
+    size_t size;
+    stack_native_limit = 1;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return;
+    if (pthread_attr_getstack(&attr, &low, &size) == 0) stack_native_enter(low, size);
+    pthread_attr_destroy(&attr);
+}
+
+size_t stack_native_size(const char *const env, size_t fallback) {
+    const char *v = getenv(env);
+    long mb = v != NULL ? strtol(v, NULL, 10) : 0;
+    return mb > 0 ? (size_t) mb << 20 : fallback;
+}
+
+extern inline bool stack_native_full(void);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "def.h"
+#include "slab.h"
+
+typedef struct _stack_segment {
+    struct _stack_segment *prev, *next; // next is kept after the stack shrinks out of it
+    uint8_t *below; // top of prev when this segment was entered
+    size_t size; // bytes after the header
+} stack_segment;
+
+// frames are bumped on the top and popped in reverse, a full segment links a larger one
+typedef struct {
+    stack_segment *seg; // segment holding top, null until the first push
+    uint8_t *base, *top, *end;
+} stack;
+
+inline void stack_init(stack *const s) {
+    s->seg = NULL;
+    s->base = s->top = s->end = NULL;
+}
+
+void *stack_push_slow(stack *const s, size_t size);
+
+// size is a multiple of 16
+inline void *stack_push(stack *const s, size_t size) {
+    if (size > (size_t) (s->end - s->top)) return stack_push_slow(s, size);
+    void *p = s->top;
+    s->top += size;
+    return p;
+}
+
+void stack_pop_slow(stack *const s);
+
+// p is the last push not popped
+inline void stack_pop(stack *const s, void *const p) {
+    s->top = p;
+    if (s->top == s->base && s->seg->prev != NULL) stack_pop_slow(s);
+}
+
+// frees every segment, nothing can be on the stack
+void stack_release(stack *const s);
+
+// calls check the native stack so deep recursion fails the run before it runs off the end
+
+// the caller now runs on size bytes from low, returns the limit to give back to stack_native_leave
+uintptr_t stack_native_enter(const void *const low, size_t size);
+
+void stack_native_leave(uintptr_t prev);
+
+// lowest address calls can go down to, 0 until looked up and 1 if the stack is not known
+extern _Thread_local uintptr_t stack_native_limit;
+
+void stack_native_find(void);
+
+// the size in MiB set by env, fallback if it is not set
+size_t stack_native_size(const char *const env, size_t fallback);
+
+// true once less than the margin is left, the stack of a pthread is looked up on first use
+inline bool stack_native_full(void) {
+    if (stack_native_limit == 0) stack_native_find();
+    return (uintptr_t) __builtin_frame_address(0) < stack_native_limit;
+}
@@ -6,3 +6,5 @@ extern inline string *string_init(size_t size);
 extern inline string *string_copy(const string *const s);
 
 extern inline void string_free(string *s);
+
+extern inline string *string_from_c(const char *const c);
@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "thread.h"
+
+#define THREAD_WAITERS_DONE ((thread*) 1)
+
+// green threads move between workers so it is only read through thread_current
+static _Thread_local thread *cur_thread = NULL;
+
+static pthread_mutex_t stacks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t num_free_stacks = 0;
+
+static void *free_stacks[THREAD_MAX_FREE_STACKS];
+
+static size_t stack_guard(void) {
+    static size_t page = 0;
+    if (page == 0) page = (size_t) sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+static void *stack_get(void) {
+    void *stack = NULL;
+    pthread_mutex_lock(&stacks_lock);
+    if (num_free_stacks > 0) stack = free_stacks[--num_free_stacks];
+    pthread_mutex_unlock(&stacks_lock);
+    if (stack != NULL) return stack;
+    stack = mmap(NULL, THREAD_STACK_SIZE + stack_guard(), PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) return NULL;
+    // overflow hits the guard page at the bottom
+    if (mprotect(stack, stack_guard(), PROT_NONE) != 0) {
+        munmap(stack, THREAD_STACK_SIZE + stack_guard());
+        return NULL;
+    }
+    return stack;
+}
+
+static void stack_put(void *stack) {
+    pthread_mutex_lock(&stacks_lock);
+    if (num_free_stacks < THREAD_MAX_FREE_STACKS) {
+        free_stacks[num_free_stacks++] = stack;
+        stack = NULL;
+    }
+    pthread_mutex_unlock(&stacks_lock);
+    if (stack != NULL) munmap(stack, THREAD_STACK_SIZE + stack_guard());
+}
+
+__attribute__((noinline)) thread *thread_current(void) {
+    return cur_thread;
+}
+
+static void thread_run(void *arg) {
+    thread *t = arg;
+    ucontext_t sched_ctx;
+    // ready can run the thread inline from inside another green thread
+    thread *prev = cur_thread;
+    t->sched_ctx = &sched_ctx;
+    cur_thread = t;
+    uintptr_t limit = stack_native_enter((char*) t->stack + stack_guard(), THREAD_STACK_SIZE);
+    atomic_store(&t->state, THREAD_STATE_PFX(RUNNING));
+    swapcontext(&sched_ctx, &t->ctx);
+    stack_native_leave(limit);
+    cur_thread = prev;
+    // the stack of the thread is no longer in use
+    void (*park)(thread *t, void *arg) = t->park;
+    void *park_arg = t->park_arg;
+    t->park = NULL;
+    park(t, park_arg);
+}
+
+static void thread_finish(thread *t, void *arg) {
+    (void) arg;
+    stack_put(t->stack);
+    t->stack = NULL;
+    thread *w = atomic_exchange(&t->waiters, THREAD_WAITERS_DONE);
+    // last access to t, joiners free it after seeing done
+    atomic_store(&t->state, THREAD_STATE_PFX(DONE));
+    while (w != NULL) {
+        thread *next = w->next_waiter;
+        thread_ready(w);
+        w = next;
+    }
+}
+
+static void thread_entry(void) {
+    thread *t = thread_current();
+    t->result = t->fn(t->arg);
+    thread_park(thread_finish, NULL);
+}
+
+static void thread_ctx_init(thread *const t) {
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = (char*) t->stack + stack_guard();
+    t->ctx.uc_stack.ss_size = THREAD_STACK_SIZE;
+    t->ctx.uc_link = NULL;
+    makecontext(&t->ctx, thread_entry, 0);
+}
+
+thread *thread_spawn(pool *const p, const var_type *const type, var_data (*fn)(void *arg), void *arg) {
+    thread *t = slab_alloc(sizeof(thread));
+    if (t == NULL) return NULL;
+    memset(t, 0, sizeof(thread));
+    if ((t->stack = stack_get()) == NULL) {
+        slab_free(t, sizeof(thread));
+        return NULL;
+    }
+    t->p = p;
+    t->fn = fn;
+    t->arg = arg;
+    t->type = type;
+    atomic_init(&t->waiters, NULL);
+    thread_ctx_init(t);
+    thread_ready(t);
+    return t;
+}
+
+void thread_free(thread *t) {
+    // the finishing worker can still be between waking joiners and setting done
+    while (atomic_load(&t->state) != THREAD_STATE_PFX(DONE)) sched_yield();
+    slab_free(t, sizeof(thread));
+}
+
+static void thread_join_park(thread *self, void *arg) {
+    thread *t = arg;
+    thread *head = atomic_load(&t->waiters);
+    do {
+        if (head == THREAD_WAITERS_DONE) {
+            thread_ready(self);
+            return;
+        }
+        self->next_waiter = head;
+    } while (!atomic_compare_exchange_weak(&t->waiters, &head, self));
+}
+
+var_data thread_join(thread *const t) {
+    if (atomic_load(&t->state) != THREAD_STATE_PFX(DONE)) {
+        if (thread_current() != NULL) thread_park(thread_join_park, t);
+        while (atomic_load(&t->state) != THREAD_STATE_PFX(DONE)) {
+            if (!pool_help(t->p)) sched_yield();
+        }
+    }
+    return t->result;
+}
+
+static void thread_yield_park(thread *t, void *arg) {
+    (void) arg;
+    thread_ready(t);
+}
+
+void thread_yield(void) {
+    if (thread_current() != NULL) thread_park(thread_yield_park, NULL);
+    else sched_yield();
+}
+
+void thread_park(void (*park)(thread *t, void *arg), void *arg) {
+    thread *t = thread_current();
+    t->park = park;
+    t->park_arg = arg;
+    atomic_store(&t->state, THREAD_STATE_PFX(PARKED));
+    swapcontext(&t->ctx, t->sched_ctx);
+}
+
+void thread_ready(thread *const t) {
+    atomic_store(&t->state, THREAD_STATE_PFX(READY));
+    pool_task_setup(&t->task, thread_run, t);
+    t->task.detached = true;
+    pool_fork(t->p, &t->task);
+}
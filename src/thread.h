@@ -0,0 +1,53 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <ucontext.h>
+#include "def.h"
+#include "slab.h"
+#include "stack.h"
+#include "var.h"
+#include "pool.h"
+
+#define THREAD_STATE_PFX(NAME) THREAD_STATE_##NAME
+
+typedef enum {
+    THREAD_STATE_PFX(READY),
+    THREAD_STATE_PFX(RUNNING),
+    THREAD_STATE_PFX(PARKED),
+    THREAD_STATE_PFX(DONE)
+} thread_state;
+
+typedef struct _thread {
+    pool_task task; // queued on the pool each time it is ready to run
+    pool *p;
+    var_data (*fn)(void *arg);
+    void *arg;
+    const var_type *type; // of the result, the return type of the spawned fn
+    var_data result;
+    _Atomic thread_state state;
+    ucontext_t ctx, *sched_ctx; // sched_ctx is the worker that is running it
+    void *stack;
+    void (*park)(struct _thread *t, void *arg); // run on the worker after the thread switched out
+    void *park_arg;
+    _Atomic(struct _thread*) waiters; // threads parked in join, THREAD_WAITERS_DONE once finished
+    struct _thread *next_waiter;
+} thread;
+
+thread *thread_spawn(pool *const p, const var_type *const type, var_data (*fn)(void *arg), void *arg);
+
+void thread_free(thread *t); // after join
+
+thread *thread_current(void); // null if not in a green thread
+
+var_data thread_join(thread *const t); // parks a green thread, anything else helps the pool
+
+void thread_yield(void);
+
+// switches out of the current green thread then runs park on the worker
+// park must make sure something calls thread_ready later
+void thread_park(void (*park)(thread *t, void *arg), void *arg);
+
+void thread_ready(thread *const t);
@@ -1,5 +1,6 @@
 
 #include "token.h"
+#include "num.h"
 
 const char *token_type_string(token_type type) {
     static const char *types[] = {
@@ -8,6 +9,7 @@ const char *token_type_string(token_type type) {
         "COMMENT",
         "VAR",
         "INT",
+        "FLOAT",
         "CHAR",
         "STRING",
         "U64",
@@ -90,10 +92,24 @@ static token_status found_token(token *const t, token_type type) {
     return TOKEN_STATUS_PFX(SOME);
 }
 
+static size_t id_char_len(const string *const s, size_t idx, bool start) {
+    if (idx >= s->len) return 0;
+    uint8_t c = (uint8_t) s->buffer[idx];
+    if (c < 0x80) return (start ? isalpha(c) : isalnum(c)) ? 1 : 0;
+    // the source was validated on load so the whole sequence is there
+    utf8 u = utf8_from_bytes(s->buffer + idx);
+    if (start ? utf8_is_id_start(utf8_code_point(u)) : utf8_is_id_continue(utf8_code_point(u))) return utf8_char_len(c);
+    return 0;
+}
+
 static token_status parse_var(token* const t, const string *const s) {
-    // enter at current letter char if the next char is not letternum dont update position
-    char peek;
-    while (isalnum(peek = peek_char(t, s))) next_char_update(t);
+    // enter at the first byte of the current char if the next char is not letternum dont update position
+    size_t len;
+    t->end_idx += utf8_char_len((uint8_t) get_char(t, s)) - 1;
+    while ((len = id_char_len(s, t->end_idx + 1, false)) > 0) {
+        t->end_idx += len;
+        t->char_no++;
+    }
     // check for type
     if (token_len(t) <= 3) {
         switch (token_char_lookup(t, s , 0)) {
@@ -118,38 +134,68 @@ static token_status parse_var(token* const t, const string *const s) {
     return found_token(t, TOKEN_PFX(VAR));
 }
 
+static size_t digits_after(const string *const s, size_t idx) {
+    return idx < s->len ? num_digits_len(s->buffer + idx, s->len - idx) : 0;
+}
+
 static token_status parse_num(token* const t, const string *const s) {
-    // TODO  floats
-    char peek;
-    while (isdigit(peek = peek_char(t, s))) next_char_update(t);
-    return found_token(t, TOKEN_PFX(INT));
+    // digits then an optional fraction and exponent, the exponent needs digits so 1e is an int then a var
+    token_type type = TOKEN_PFX(INT);
+    size_t len = num_digits_len(s->buffer + t->end_idx, s->len - t->end_idx), frac, exp;
+    if (peek_char_n(t, s, len) == '.' && (frac = digits_after(s, t->end_idx + len + 1)) > 0) {
+        len += 1 + frac;
+        type = TOKEN_PFX(FLOAT);
+    }
+    if ((peek_char_n(t, s, len) | 0x20) == 'e') {
+        size_t sign = peek_char_n(t, s, len + 1) == '-' || peek_char_n(t, s, len + 1) == '+';
+        if ((exp = digits_after(s, t->end_idx + len + 1 + sign)) > 0) {
+            len += 1 + sign + exp;
+            type = TOKEN_PFX(FLOAT);
+        }
+    }
+    t->end_idx += len - 1;
+    t->char_no += len - 1;
+    return found_token(t, type);
+}
+
+static size_t count_chars(const char *const buf, size_t len) {
+    // every byte that is not a continuation starts a char
+    size_t i = 0, n = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, buf + i, sizeof(w));
+        n += 8 - __builtin_popcountll(w & ~(w << 1) & 0x8080808080808080);
+    }
+    for (; i < len; i++) if (((uint8_t) buf[i] & 0xC0) != 0x80) n++;
+    return n;
+}
+
+static void next_chars_update(token *const t, const string *const s, size_t len) {
+    t->char_no += count_chars(s->buffer + t->end_idx + 1, len);
+    t->end_idx += len;
 }
 
 static token_status parse_string(token* const t, const string *const s) {
     static const size_t max_inline_string_size = 1024;
     // we are on first "
-    char peek = peek_char(t, s);
-    if (peek == '"') {
-        // empty string
-        next_char_update(t);
-        return found_token(t, TOKEN_PFX(STRING));
-    }
-    size_t pos = 0;
-    while ((peek = peek_char(t, s)) != '"') {
-        next_char_update(t);
-        if (++pos >= max_inline_string_size) return TOKEN_STATUS_PFX(EXCEDED_MAX_STRING_LEN);
-    }
-    next_char_update(t);
-    // char if 3 chars for char of 4 chars for escape char
-    // TODO utf8 char
-    if (token_len(t) == 3 || (token_len(t) == 4 && s->buffer[t->start_idx + 1] == '\\')) t->type = TOKEN_PFX(CHAR);
+    size_t start = t->end_idx + 1, max = s->len > start ? s->len - start : 0;
+    if (max > max_inline_string_size) max = max_inline_string_size;
+    const char *end = memchr(s->buffer + start, '"', max);
+    if (end == NULL) return TOKEN_STATUS_PFX(EXCEDED_MAX_STRING_LEN);
+    next_chars_update(t, s, end - (s->buffer + start) + 1);
+    // char if one utf8 char between the quotes or 4 chars for escape char
+    size_t len = token_len(t) - 2;
+    if (len > 0 && ((s->buffer[start] != '\\' && len == utf8_char_len((uint8_t) s->buffer[start])) || (len == 2 && s->buffer[start] == '\\'))) t->type = TOKEN_PFX(CHAR);
     else t->type = TOKEN_PFX(STRING);
     return TOKEN_STATUS_PFX(SOME);
 }
 
 static token_status parse_comment(token* const t, const string *const s) {
     // on thing after //
-    while (get_char(t, s) != '\n') next_char_update(t);
+    size_t start = t->end_idx + 1;
+    const char *end = start < s->len ? memchr(s->buffer + start, '\n', s->len - start) : NULL;
+    // ends on the newline
+    next_chars_update(t, s, (end != NULL ? (size_t) (end - s->buffer) + 1 : s->len) - start);
     t->type = TOKEN_PFX(COMMENT);
     return TOKEN_STATUS_PFX(SOME);
 }
@@ -169,8 +215,8 @@ token_status token_next(token *const t, const string *const s) {
     remove_spaces(t, s);
     char c = get_char(t, s);
     if (c == '\0') return TOKEN_STATUS_PFX(NONE);
-    if (isalpha(c)) return parse_var(t, s);
-    if (isdigit(c)) return parse_num(t, s);
+    if (id_char_len(s, t->end_idx, true) > 0) return parse_var(t, s);
+    if (isdigit((uint8_t) c)) return parse_num(t, s);
     if (c == '"') return parse_string(t, s);
     switch (c) {
         case '{':
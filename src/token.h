@@ -6,6 +6,7 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include "string.h"
+#include "utf8.h"
 
 #define TOKEN_PFX(NAME) TOKEN_##NAME
 
@@ -16,6 +17,7 @@ typedef enum {
     // Values
     TOKEN_PFX(VAR),
     TOKEN_PFX(INT),
+    TOKEN_PFX(FLOAT),
     TOKEN_PFX(CHAR),
     TOKEN_PFX(STRING),
     // Types
@@ -1,5 +1,6 @@
 
 #include "type.h"
+#include "hash.h"
 
 const char *var_type_header_string(var_type_header header) {
     static const char *types[] = {
@@ -152,6 +153,9 @@ void var_type_free(var_type *t) {
             case VAR_PFX(VEC):
                 var_type_vec_free(t->body.vec);
                 break;
+            case VAR_PFX(HASH):
+                var_type_hash_free(t->body.hash);
+                break;
             case VAR_PFX(FN):
                 var_type_fn_free(t->body.fn);
                 break;
@@ -169,6 +173,9 @@ void var_type_copy(var_type *const dest, const var_type *const src) {
         case VAR_PFX(VEC):
             dest->body.vec = src->body.vec;
             break;
+        case VAR_PFX(HASH):
+            dest->body.hash = src->body.hash;
+            break;
         case VAR_PFX(FN):
             dest->body.fn = src->body.fn;
             break;
@@ -183,6 +190,14 @@ bool var_type_equal(const var_type *const left, const var_type *const right) {
     if (left == NULL || right == NULL) return false;
     if (left->header != right->header) return false;
     switch (left->header) {
+        case VAR_PFX(VEC):
+            // vecs with a single item type must have the same one
+            if (left->body.vec->dynamic == NULL && right->body.vec->dynamic == NULL) return true;
+            return var_type_equal(left->body.vec->dynamic, right->body.vec->dynamic);
+        case VAR_PFX(HASH):
+            // fixed keys are a layout of their own
+            if (left->body.hash->keys != NULL || right->body.hash->keys != NULL) return left->body.hash == right->body.hash;
+            return var_type_equal(left->body.hash->dynamic, right->body.hash->dynamic);
         case VAR_PFX(FN):
             return left->body.fn == right->body.fn;
         default:
@@ -195,6 +210,24 @@ extern inline var_type *var_type_vec_init(size_t len);
 
 extern inline void var_type_vec_free(var_type_vec *v);
 
+extern inline var_type *var_type_hash_init(bool fixed);
+
+void var_type_hash_free(var_type_hash *h) {
+    var_type_free(h->dynamic);
+    if (h->keys != NULL) symbol_table_free(h->keys);
+    if (h->perfect != NULL) hash_perfect_free(h->perfect);
+    free(h);
+}
+
+void var_type_hash_fix_keys(var_type_hash *const h) {
+    // values are laid out like a struct, key access is a constant offset
+    for (size_t i = 0; i < h->keys->size; i++)
+        for (symbol_table_bucket *b = h->keys->buckets[i]; b != NULL; b = b->next) b->idx.key = b->symbol_idx;
+    h->len = h->keys->symbol_counter;
+    if (h->perfect != NULL) hash_perfect_free(h->perfect);
+    h->perfect = hash_perfect_init(h->keys);
+}
+
 extern inline var_type *var_type_fn_init(size_t symbol_table_size);
 
 extern inline void var_type_fn_free(var_type_fn *f);
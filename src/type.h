@@ -116,6 +116,7 @@ inline symbol_table_bucket *symbol_table_findsert(symbol_table **const table, sy
 
 typedef struct {
     size_t num_args, num_locals;
+    bool pure; // no writes or assigns outside of own symbols, set before run
     var_type *return_type; // added on parse
     symbol_table* symbols;
     symbol_table_bucket *args[];// types of each arg
@@ -126,13 +127,18 @@ typedef struct {
     var_type *dynamic, *items[]; // all items have dynamic type
 } var_type_vec;
 
+typedef struct _hash_perfect hash_perfect;
+
+typedef struct {
+    size_t len; // 0 for dynamic
+    var_type *dynamic; // all keys have this type
+    symbol_table *keys; // if fixed the value of a key is at idx.key
+    hash_perfect *perfect; // dynamic lookups into fixed keys, set by var_type_hash_fix_keys
+} var_type_hash;
+
 typedef union {
     var_type_vec *vec;
-    struct {
-        size_t len; // 0 for dynamic
-        var_type *dynamic; // all keys have this type
-        symbol_table *keys;
-    } *hash;
+    var_type_hash *hash;
     var_type_fn *fn;
 } var_type_body;
 
@@ -163,7 +169,7 @@ bool var_type_equal(const var_type *const left, const var_type *const right);
 inline var_type *var_type_vec_init(size_t len) {
     var_type_vec *v;
     if (len  > 0) {
-        v = calloc(1, sizeof(var_type_vec) + sizeof(var_type) * sizeof(var_type*));
+        v = calloc(1, sizeof(var_type_vec) + sizeof(var_type*) * len);
         v->len = len;
     } else {
         v = calloc(1, sizeof(var_type_vec));
@@ -177,6 +183,16 @@ inline void var_type_vec_free(var_type_vec *v) {
     free(v);
 }
 
+inline var_type *var_type_hash_init(bool fixed) {
+    var_type_hash *h = calloc(1, sizeof(var_type_hash));
+    if (fixed == true) h->keys = symbol_table_init(DEFAULT_SYMBOL_TABLE_SIZE);
+    return var_type_init(VAR_PFX(HASH), true, (var_type_body) { .hash = h });
+}
+
+void var_type_hash_free(var_type_hash *h);
+
+void var_type_hash_fix_keys(var_type_hash *const h); // keys get a dense idx in insert order
+
 inline var_type *var_type_fn_init(size_t symbol_table_size) {
     var_type_fn *fn = calloc(1, sizeof(var_type_fn) + sizeof(symbol_table_bucket*) * AST_MAX_ARGS);
     fn->symbols = symbol_table_init(symbol_table_size);
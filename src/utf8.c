@@ -1,4 +1,227 @@
 
 #include "utf8.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 extern inline utf8 utf8_from_c_char(char c);
+
+extern inline size_t utf8_char_len(uint8_t lead);
+
+extern inline utf8 utf8_from_bytes(const char *const buf);
+
+extern inline uint32_t utf8_code_point(utf8 u);
+
+utf8 utf8_from_code_point(uint32_t cp) {
+    utf8 u = (utf8) { .c = { [0 ... 3] = '\0' } };
+    if (cp < 0x80) {
+        u.c[0] = cp;
+    } else if (cp < 0x800) {
+        u.c[0] = 0xC0 | cp >> 6;
+        u.c[1] = 0x80 | (cp & 0x3F);
+    } else if (cp < 0x10000) {
+        u.c[0] = 0xE0 | cp >> 12;
+        u.c[1] = 0x80 | (cp >> 6 & 0x3F);
+        u.c[2] = 0x80 | (cp & 0x3F);
+    } else {
+        u.c[0] = 0xF0 | (cp >> 18 & 0x07);
+        u.c[1] = 0x80 | (cp >> 12 & 0x3F);
+        u.c[2] = 0x80 | (cp >> 6 & 0x3F);
+        u.c[3] = 0x80 | (cp & 0x3F);
+    }
+    return u;
+}
+
+#define ASCII_MASK 0x8080808080808080
+
+static size_t validate_scalar(const uint8_t *const buf, size_t pos, size_t len) {
+    while (pos < len) {
+        // a word at a time while ascii
+        if (pos + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, buf + pos, sizeof(w));
+            if ((w & ASCII_MASK) == 0) {
+                pos += 8;
+                continue;
+            }
+        }
+        uint8_t b = buf[pos];
+        if (b < 0x80) {
+            pos++;
+            continue;
+        }
+        size_t n;
+        uint8_t lo = 0x80, hi = 0xBF; // range of the second byte
+        if (b >= 0xC2 && b <= 0xDF) n = 2;
+        else if (b >= 0xE0 && b <= 0xEF) n = 3;
+        else if (b >= 0xF0 && b <= 0xF4) n = 4;
+        else return pos;
+        // overlongs, surrogates and past 10FFFF
+        if (b == 0xE0) lo = 0xA0;
+        else if (b == 0xED) hi = 0x9F;
+        else if (b == 0xF0) lo = 0x90;
+        else if (b == 0xF4) hi = 0x8F;
+        if (pos + n > len || buf[pos + 1] < lo || buf[pos + 1] > hi) return pos;
+        for (size_t i = 2; i < n; i++) if ((buf[pos + i] & 0xC0) != 0x80) return pos;
+        pos += n;
+    }
+    return len;
+}
+
+#if defined(__x86_64__)
+
+// keiser and lemire, each byte pair is classified with three nibble lookups
+// a bit set in all three is an error except for the 3rd and 4th bytes of a sequence
+
+#define TOO_SHORT (1 << 0)
+#define TOO_LONG (1 << 1)
+#define OVERLONG_3 (1 << 2)
+#define TOO_LARGE (1 << 3)
+#define SURROGATE (1 << 4)
+#define OVERLONG_2 (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4 (1 << 6)
+#define TWO_CONTS (1 << 7)
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__((target("ssse3"))) static inline __m128i nibble_hi(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+__attribute__((target("ssse3"))) static inline __m128i check_block(__m128i input, __m128i prev) {
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte_1_high_table, nibble_hi(prev1)),
+            _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)))),
+        _mm_shuffle_epi8(byte_2_high_table, nibble_hi(input)));
+    // continuations two or three bytes after a 3 or 4 byte lead
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8((char) (0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8((char) (0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char) 0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+// a lead in the last three bytes that needs more bytes than are left
+__attribute__((target("ssse3"))) static inline __m128i check_incomplete(__m128i input) {
+    const __m128i max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+    return _mm_subs_epu8(input, max);
+}
+
+__attribute__((target("ssse3"))) static bool validate_ssse3(const uint8_t *const buf, size_t len) {
+    __m128i error = _mm_setzero_si128(), prev = _mm_setzero_si128(), incomplete = _mm_setzero_si128();
+    size_t pos = 0;
+    for (;;) {
+        __m128i input;
+        if (pos + 16 <= len) {
+            input = _mm_loadu_si128((const __m128i*) (buf + pos));
+        } else {
+            if (pos == len) break;
+            // zero padding is ascii so it closes off the last block
+            uint8_t tail[16] = { 0 };
+            memcpy(tail, buf + pos, len - pos);
+            input = _mm_loadu_si128((const __m128i*) tail);
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            // ascii only needs the previous block to have ended a sequence
+            error = _mm_or_si128(error, incomplete);
+        } else {
+            error = _mm_or_si128(error, check_block(input, prev));
+            incomplete = check_incomplete(input);
+        }
+        prev = input;
+        pos += 16;
+        if (pos >= len) break;
+    }
+    error = _mm_or_si128(error, incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#endif
+
+size_t utf8_validate(const char *const buf, size_t len) {
+#if defined(__x86_64__)
+    static int has_ssse3 = -1;
+    if (has_ssse3 == -1) has_ssse3 = __builtin_cpu_supports("ssse3");
+    // the vector pass only says if there is an error, the scalar one finds where
+    if (has_ssse3 && validate_ssse3((const uint8_t*) buf, len)) return len;
+#endif
+    return validate_scalar((const uint8_t*) buf, 0, len);
+}
+
+typedef struct {
+    uint32_t lo, hi;
+} id_range;
+
+static bool in_ranges(const id_range *const ranges, size_t num, uint32_t cp) {
+    size_t lo = 0, hi = num;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < ranges[mid].lo) hi = mid;
+        else if (cp > ranges[mid].hi) lo = mid + 1;
+        else return true;
+    }
+    return false;
+}
+
+static const id_range id_allowed[] = {
+    { 0x00A8, 0x00A8 }, { 0x00AA, 0x00AA }, { 0x00AD, 0x00AD }, { 0x00AF, 0x00AF },
+    { 0x00B2, 0x00B5 }, { 0x00B7, 0x00BA }, { 0x00BC, 0x00BE }, { 0x00C0, 0x00D6 },
+    { 0x00D8, 0x00F6 }, { 0x00F8, 0x00FF }, { 0x0100, 0x167F }, { 0x1681, 0x180D },
+    { 0x180F, 0x1FFF }, { 0x200B, 0x200D }, { 0x202A, 0x202E }, { 0x203F, 0x2040 },
+    { 0x2054, 0x2054 }, { 0x2060, 0x206F }, { 0x2070, 0x218F }, { 0x2460, 0x24FF },
+    { 0x2776, 0x2793 }, { 0x2C00, 0x2DFF }, { 0x2E80, 0x2FFF }, { 0x3004, 0x3007 },
+    { 0x3021, 0x302F }, { 0x3031, 0x303F }, { 0x3040, 0xD7FF }, { 0xF900, 0xFD3D },
+    { 0xFD40, 0xFDCF }, { 0xFDF0, 0xFE44 }, { 0xFE47, 0xFFFD }, { 0x10000, 0x1FFFD },
+    { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD }, { 0x40000, 0x4FFFD }, { 0x50000, 0x5FFFD },
+    { 0x60000, 0x6FFFD }, { 0x70000, 0x7FFFD }, { 0x80000, 0x8FFFD }, { 0x90000, 0x9FFFD },
+    { 0xA0000, 0xAFFFD }, { 0xB0000, 0xBFFFD }, { 0xC0000, 0xCFFFD }, { 0xD0000, 0xDFFFD },
+    { 0xE0000, 0xEFFFD }
+};
+
+// combining marks
+static const id_range id_not_start[] = {
+    { 0x0300, 0x036F }, { 0x1DC0, 0x1DFF }, { 0x20D0, 0x20FF }, { 0xFE20, 0xFE2F }
+};
+
+bool utf8_is_id_start(uint32_t cp) {
+    if (cp < 0x80) return (cp | 0x20) >= 'a' && (cp | 0x20) <= 'z';
+    return utf8_is_id_continue(cp) && !in_ranges(id_not_start, sizeof(id_not_start) / sizeof(id_range), cp);
+}
+
+bool utf8_is_id_continue(uint32_t cp) {
+    if (cp < 0x80) return (cp >= '0' && cp <= '9') || ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z');
+    return in_ranges(id_allowed, sizeof(id_allowed) / sizeof(id_range), cp);
+}
@@ -1,8 +1,9 @@
-
 #pragma once
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 
 typedef struct {
     uint8_t c[4];
@@ -13,3 +14,36 @@ inline utf8 utf8_from_c_char(char c) {
     u.c[0] = c;
     return u;
 }
+
+// only valid on validated input
+inline size_t utf8_char_len(uint8_t lead) {
+    if (lead < 0x80) return 1;
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    return 4;
+}
+
+inline utf8 utf8_from_bytes(const char *const buf) {
+    utf8 u = (utf8) { .c = { [0 ... 3] = '\0' } };
+    memcpy(u.c, buf, utf8_char_len((uint8_t) buf[0]));
+    return u;
+}
+
+inline uint32_t utf8_code_point(utf8 u) {
+    switch (utf8_char_len(u.c[0])) {
+        case 1: return u.c[0];
+        case 2: return (u.c[0] & 0x1F) << 6 | (u.c[1] & 0x3F);
+        case 3: return (u.c[0] & 0x0F) << 12 | (u.c[1] & 0x3F) << 6 | (u.c[2] & 0x3F);
+        default: return (u.c[0] & 0x07) << 18 | (u.c[1] & 0x3F) << 12 | (u.c[2] & 0x3F) << 6 | (u.c[3] & 0x3F);
+    }
+}
+
+utf8 utf8_from_code_point(uint32_t cp);
+
+// returns len if valid or the index of the first byte of the bad sequence
+size_t utf8_validate(const char *const buf, size_t len);
+
+// identifier chars from annex d of c11
+bool utf8_is_id_start(uint32_t cp);
+
+bool utf8_is_id_continue(uint32_t cp);
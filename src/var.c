@@ -1,2 +1,200 @@
 
 #include "var.h"
+
+uint64_t var_data_to_u64(var_type_header header, var_data data) {
+    switch (header) {
+        case VAR_PFX(U8): return data.u8;
+        case VAR_PFX(U16): return data.u16;
+        case VAR_PFX(U32): return data.u32;
+        case VAR_PFX(U64): return data.u64;
+        case VAR_PFX(I8): return (uint64_t) data.i8;
+        case VAR_PFX(I16): return (uint64_t) data.i16;
+        case VAR_PFX(I32): return (uint64_t) data.i32;
+        case VAR_PFX(I64): return (uint64_t) data.i64;
+        case VAR_PFX(CHAR): return utf8_code_point(data.c);
+        case VAR_PFX(FD): return (uint64_t) data.fd;
+        case VAR_PFX(F32): return (uint64_t) (int64_t) data.f32;
+        case VAR_PFX(F64): return (uint64_t) (int64_t) data.f64;
+        default: break;
+    }
+    return 0;
+}
+
+var_data var_data_from_u64(var_type_header header, uint64_t v) {
+    var_data data = { .u64 = 0 };
+    switch (header) {
+        case VAR_PFX(U8): data.u8 = (uint8_t) v; break;
+        case VAR_PFX(U16): data.u16 = (uint16_t) v; break;
+        case VAR_PFX(U32): data.u32 = (uint32_t) v; break;
+        case VAR_PFX(U64): data.u64 = v; break;
+        case VAR_PFX(I8): data.i8 = (int8_t) v; break;
+        case VAR_PFX(I16): data.i16 = (int16_t) v; break;
+        case VAR_PFX(I32): data.i32 = (int32_t) v; break;
+        case VAR_PFX(I64): data.i64 = (int64_t) v; break;
+        case VAR_PFX(CHAR): data.c = utf8_from_code_point((uint32_t) v); break;
+        case VAR_PFX(FD): data.fd = (int) v; break;
+        case VAR_PFX(F32): data.f32 = (float) (int64_t) v; break;
+        case VAR_PFX(F64): data.f64 = (double) (int64_t) v; break;
+        default: break;
+    }
+    return data;
+}
+
+double var_data_to_f64(var_type_header header, var_data data) {
+    if (header == VAR_PFX(F32)) return data.f32;
+    if (header == VAR_PFX(F64)) return data.f64;
+    if (var_type_is_signed(header)) return (double) (int64_t) var_data_to_u64(header, data);
+    return (double) var_data_to_u64(header, data);
+}
+
+var_data var_data_from_f64(var_type_header header, double v) {
+    var_data data = { .u64 = 0 };
+    if (header == VAR_PFX(F32)) data.f32 = (float) v;
+    else if (header == VAR_PFX(F64)) data.f64 = v;
+    else if (var_type_is_signed(header)) data = var_data_from_u64(header, (uint64_t) (int64_t) v);
+    else data = var_data_from_u64(header, (uint64_t) v);
+    return data;
+}
+
+extern inline var_data var_data_cast(var_type_header to, var_type_header from, var_data data);
+
+var_data var_data_add(var_type_header header, var_data left, var_data right) {
+    if (var_type_is_float(header)) return var_data_from_f64(header, var_data_to_f64(header, left) + var_data_to_f64(header, right));
+    // unsigned wrap around is the same for signed ints
+    return var_data_from_u64(header, var_data_to_u64(header, left) + var_data_to_u64(header, right));
+}
+
+var_data var_data_sub(var_type_header header, var_data left, var_data right) {
+    if (var_type_is_float(header)) return var_data_from_f64(header, var_data_to_f64(header, left) - var_data_to_f64(header, right));
+    return var_data_from_u64(header, var_data_to_u64(header, left) - var_data_to_u64(header, right));
+}
+
+bool var_data_equal(var_type_header header, var_data left, var_data right) {
+    if (var_type_is_float(header)) return var_data_to_f64(header, left) == var_data_to_f64(header, right);
+    return var_data_to_u64(header, left) == var_data_to_u64(header, right);
+}
+
+bool var_data_less_equal(var_type_header header, var_data left, var_data right) {
+    if (var_type_is_float(header)) return var_data_to_f64(header, left) <= var_data_to_f64(header, right);
+    if (var_type_is_signed(header)) return (int64_t) var_data_to_u64(header, left) <= (int64_t) var_data_to_u64(header, right);
+    return var_data_to_u64(header, left) <= var_data_to_u64(header, right);
+}
+
+extern inline bool var_value_is_int(var_value v);
+
+extern inline var_tag var_value_tag(var_value v);
+
+extern inline int64_t var_value_int(var_value v);
+
+extern inline var_value var_value_from_int(int64_t i);
+
+extern inline bool var_value_int_fits(int64_t i);
+
+extern inline uint32_t var_value_imm(var_value v);
+
+extern inline var_value var_value_from_imm(uint32_t imm, var_tag tag);
+
+extern inline void *var_value_ptr(var_value v);
+
+extern inline var_value var_value_from_ptr(const void *const p, var_tag tag);
+
+static var_value var_value_box(var_type_header header, var_data data) {
+    var_box *b = slab_alloc(sizeof(var_box));
+    b->header = header;
+    b->data = data;
+    return var_value_from_ptr(b, VAR_TAG_PFX(BOX));
+}
+
+var_value var_value_from_data(var_type_header header, var_data data) {
+    uint32_t imm;
+    switch (header) {
+        case VAR_PFX(U8):
+        case VAR_PFX(U16):
+        case VAR_PFX(U32):
+        case VAR_PFX(I8):
+        case VAR_PFX(I16):
+        case VAR_PFX(I32):
+            return var_value_from_int((int64_t) var_data_to_u64(header, data));
+        case VAR_PFX(U64):
+            if (data.u64 <= INT64_MAX / 2) return var_value_from_int(data.u64);
+            break;
+        case VAR_PFX(I64):
+            if (var_value_int_fits(data.i64)) return var_value_from_int(data.i64);
+            break;
+        case VAR_PFX(CHAR):
+            memcpy(&imm, data.c.c, sizeof(imm));
+            return var_value_from_imm(imm, VAR_TAG_PFX(CHAR));
+        case VAR_PFX(FD):
+            return var_value_from_imm((uint32_t) data.fd, VAR_TAG_PFX(FD));
+        case VAR_PFX(STRING):
+            return var_value_from_ptr(data.str, VAR_TAG_PFX(STRING));
+        case VAR_PFX(HASH):
+            return var_value_from_ptr(data.h, VAR_TAG_PFX(HASH));
+        case VAR_PFX(VEC):
+            return var_value_from_ptr(data.v, VAR_TAG_PFX(VEC));
+        case VAR_PFX(FN):
+            return var_value_from_ptr(data.fn, VAR_TAG_PFX(FN));
+        case VAR_PFX(THREAD):
+            return var_value_from_ptr(data.t, VAR_TAG_PFX(THREAD));
+        default:
+            break;
+    }
+    return var_value_box(header, data);
+}
+
+var_data var_value_to_data(var_value v, var_type_header header) {
+    var_data data = { .u64 = 0 };
+    uint32_t imm;
+    if (var_value_is_int(v)) return var_data_from_u64(header, (uint64_t) var_value_int(v));
+    switch (var_value_tag(v)) {
+        case VAR_TAG_PFX(CHAR):
+            imm = var_value_imm(v);
+            memcpy(data.c.c, &imm, sizeof(imm));
+            break;
+        case VAR_TAG_PFX(FD):
+            data.fd = (int) var_value_imm(v);
+            break;
+        case VAR_TAG_PFX(STRING):
+            data.str = var_value_ptr(v);
+            break;
+        case VAR_TAG_PFX(HASH):
+            data.h = var_value_ptr(v);
+            break;
+        case VAR_TAG_PFX(VEC):
+            data.v = var_value_ptr(v);
+            break;
+        case VAR_TAG_PFX(FN):
+            data.fn = var_value_ptr(v);
+            break;
+        case VAR_TAG_PFX(THREAD):
+            data.t = var_value_ptr(v);
+            break;
+        case VAR_TAG_PFX(BOX):
+            data = ((var_box*) var_value_ptr(v))->data;
+            break;
+        default:
+            break;
+    }
+    return data;
+}
+
+var_type_header var_value_header(var_value v) {
+    // ints lose their width, the static type has it
+    if (var_value_is_int(v)) return VAR_PFX(I64);
+    switch (var_value_tag(v)) {
+        case VAR_TAG_PFX(CHAR): return VAR_PFX(CHAR);
+        case VAR_TAG_PFX(FD): return VAR_PFX(FD);
+        case VAR_TAG_PFX(STRING): return VAR_PFX(STRING);
+        case VAR_TAG_PFX(HASH): return VAR_PFX(HASH);
+        case VAR_TAG_PFX(VEC): return VAR_PFX(VEC);
+        case VAR_TAG_PFX(FN): return VAR_PFX(FN);
+        case VAR_TAG_PFX(THREAD): return VAR_PFX(THREAD);
+        case VAR_TAG_PFX(BOX): return ((var_box*) var_value_ptr(v))->header;
+        default: break;
+    }
+    return VAR_PFX(UNKNOWN);
+}
+
+void var_value_free(var_value v) {
+    if (var_value_is_int(v) == false && var_value_tag(v) == VAR_TAG_PFX(BOX)) slab_free(var_value_ptr(v), sizeof(var_box));
+}
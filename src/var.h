@@ -8,6 +8,16 @@
 #include "string.h"
 #include "utf8.h"
 #include "hash.h"
+#include "vec.h"
+#include "rope.h"
+
+typedef struct _ast_fn_node ast_fn_node;
+
+typedef struct _thread thread;
+
+typedef struct _regex regex;
+
+typedef struct _var_closure var_closure;
 
 typedef union {
     uint8_t u8;
@@ -18,13 +28,118 @@ typedef union {
     int16_t i16;
     int32_t i32;
     int64_t i64;
+    float f32;
+    double f64;
     utf8 c;
-    string *str;
+    rope *str; // flattened only when the bytes must be contiguous
     hash *h;
+    var_value *rec; // hash with fixed keys, the value of a key is at its idx.key
+    vec *v; // packed items of the dynamic type
     int fd;
+    var_closure *fn;
+    thread *t; // green thread, join gives the return type of the spawned fn
+    regex *re; // boxed, the dfa cache is filled by matching so one thread at a time
 } var_data;
 
+// a fn with the slots it captured from the frames it was made in
+typedef struct _var_closure {
+    const ast_fn_node *fn;
+    var_data *env[];
+} var_closure;
+
 typedef struct _var {
     var_type *type;
     var_data data;
 } var;
+
+#define VAR_TAG_PFX(NAME) VAR_TAG_##NAME
+
+typedef enum {
+    VAR_TAG_PFX(STRING) = 0x0,
+    VAR_TAG_PFX(CHAR) = 0x2,
+    VAR_TAG_PFX(FD) = 0x4,
+    VAR_TAG_PFX(HASH) = 0x6,
+    VAR_TAG_PFX(VEC) = 0x8,
+    VAR_TAG_PFX(FN) = 0xA,
+    VAR_TAG_PFX(BOX) = 0xC, // anything that is not an immediate or has no tag
+    VAR_TAG_PFX(THREAD) = 0xE
+} var_tag;
+
+#define VAR_TAG_MASK 0xF
+
+// for values whose type is not known statically, bit 0 set is a 63 bit int
+// otherwise the low 4 bits are the tag, immediates are stored in the upper 32 bits
+// and heap pointers are 16 byte aligned from malloc
+typedef uint64_t var_value;
+
+_Static_assert(sizeof(var_value) == sizeof(var_data), "frames hold untagged var_data of the same size");
+
+typedef struct {
+    var_type_header header;
+    var_data data;
+} var_box;
+
+inline bool var_value_is_int(var_value v) {
+    return (v & 1) == 1;
+}
+
+inline var_tag var_value_tag(var_value v) {
+    return v & VAR_TAG_MASK;
+}
+
+inline int64_t var_value_int(var_value v) {
+    return (int64_t) v >> 1;
+}
+
+inline var_value var_value_from_int(int64_t i) {
+    return ((uint64_t) i << 1) | 1;
+}
+
+inline bool var_value_int_fits(int64_t i) {
+    return i >= INT64_MIN / 2 && i <= INT64_MAX / 2;
+}
+
+inline uint32_t var_value_imm(var_value v) {
+    return v >> 32;
+}
+
+inline var_value var_value_from_imm(uint32_t imm, var_tag tag) {
+    return ((uint64_t) imm << 32) | tag;
+}
+
+inline void *var_value_ptr(var_value v) {
+    return (void*) (uintptr_t) (v & ~(uint64_t) VAR_TAG_MASK);
+}
+
+inline var_value var_value_from_ptr(const void *const p, var_tag tag) {
+    return (uintptr_t) p | tag;
+}
+
+var_value var_value_from_data(var_type_header header, var_data data);
+
+var_data var_value_to_data(var_value v, var_type_header header);
+
+var_type_header var_value_header(var_value v); // the header the value was made from
+
+void var_value_free(var_value v); // only frees boxes, heap objects are owned elsewhere
+
+uint64_t var_data_to_u64(var_type_header header, var_data data);
+
+var_data var_data_from_u64(var_type_header header, uint64_t v);
+
+double var_data_to_f64(var_type_header header, var_data data);
+
+var_data var_data_from_f64(var_type_header header, double v);
+
+inline var_data var_data_cast(var_type_header to, var_type_header from, var_data data) {
+    if (var_type_is_float(to) || var_type_is_float(from)) return var_data_from_f64(to, var_data_to_f64(from, data));
+    return var_data_from_u64(to, var_data_to_u64(from, data));
+}
+
+var_data var_data_add(var_type_header header, var_data left, var_data right);
+
+var_data var_data_sub(var_type_header header, var_data left, var_data right);
+
+bool var_data_equal(var_type_header header, var_data left, var_data right);
+
+bool var_data_less_equal(var_type_header header, var_data left, var_data right);
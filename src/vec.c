@@ -0,0 +1,207 @@
+
+#include "vec.h"
+
+size_t vec_item_size(var_type_header header) {
+    switch (header) {
+        case VAR_PFX(U8):
+        case VAR_PFX(I8):
+            return 1;
+        case VAR_PFX(U16):
+        case VAR_PFX(I16):
+            return 2;
+        case VAR_PFX(U32):
+        case VAR_PFX(I32):
+        case VAR_PFX(F32):
+            return 4;
+        case VAR_PFX(U64):
+        case VAR_PFX(I64):
+        case VAR_PFX(F64):
+            return 8;
+        default:
+            break;
+    }
+    return 0;
+}
+
+extern inline size_t vec_items_bytes(size_t size, size_t item_size);
+
+static uint8_t *items_alloc(region *const r, size_t size, size_t item_size) {
+    // cache line aligned so threads splitting the items on line boundaries never share a line
+    if (r != NULL) return region_alloc(r, vec_items_bytes(size, item_size), CACHE_LINE_SIZE);
+    return slab_alloc(vec_items_bytes(size, item_size));
+}
+
+vec *vec_init_region(region *const r, var_type_header header, size_t size) {
+    // 16 byte aligned like malloc so the pointer can be tagged as a var_value
+    vec *v = r != NULL ? region_alloc(r, sizeof(vec), 16) : slab_alloc(sizeof(vec));
+    memset(v, 0, sizeof(vec));
+    v->header = header;
+    v->item_size = vec_item_size(header);
+    v->size = size > 0 ? size : VEC_DEFAULT_SIZE;
+    v->items = items_alloc(r, v->size, v->item_size);
+    v->r = r;
+    atomic_init(&v->refs, 1);
+    return v;
+}
+
+vec *vec_init(var_type_header header, size_t size) {
+    return vec_init_region(NULL, header, size);
+}
+
+extern inline vec *vec_retain(vec *const v);
+
+extern inline void vec_free(vec *v);
+
+extern inline bool vec_unique(vec *const v);
+
+extern inline vec *vec_promote(vec *const v);
+
+vec *vec_copy(const vec *const v) {
+    vec *copy = vec_init(v->header, v->len);
+    copy->len = v->len;
+    memcpy(copy->items, v->items, v->len * v->item_size);
+    return copy;
+}
+
+void vec_push(vec **const v, const void *const item) {
+    if ((*v)->len >= (*v)->size) {
+        // in a region the old items stay until the region is freed
+        uint8_t *items = items_alloc((*v)->r, (*v)->size * 2, (*v)->item_size);
+        memcpy(items, (*v)->items, (*v)->len * (*v)->item_size);
+        if ((*v)->r == NULL) slab_free((*v)->items, vec_items_bytes((*v)->size, (*v)->item_size));
+        (*v)->items = items;
+        (*v)->size *= 2;
+    }
+    memcpy(vec_get(*v, (*v)->len++), item, (*v)->item_size);
+}
+
+extern inline void *vec_get(const vec *const v, size_t idx);
+
+// kernels are written with gcc vector types, each is built for avx2 and the
+// baseline sse2 and picked when the program loads
+#if defined(__x86_64__) && defined(__GNUC__)
+    #define VEC_TARGET __attribute__((target_clones("avx2", "default")))
+#else
+    #define VEC_TARGET
+#endif
+
+#define VEC_LANES(T) (VEC_SIMD_BYTES / sizeof(T))
+
+typedef void vec_kernel(size_t len, const void *a_items, bool a_scalar, const void *b_items, bool b_scalar, void *out_items);
+
+#define VEC_KERNEL_LOOP(T, STORE) \
+    typedef T simd __attribute__((vector_size(VEC_SIMD_BYTES))); \
+    const T *a = a_items, *b = b_items; \
+    simd va = (simd) { 0 } + a[0], vb = (simd) { 0 } + b[0]; \
+    size_t i = 0; \
+    if (a_scalar == false && b_scalar == false) { \
+        for (; i + VEC_LANES(T) <= len; i += VEC_LANES(T)) { \
+            memcpy(&va, a + i, sizeof(simd)); \
+            memcpy(&vb, b + i, sizeof(simd)); \
+            STORE; \
+        } \
+    } else if (a_scalar == false) { \
+        for (; i + VEC_LANES(T) <= len; i += VEC_LANES(T)) { \
+            memcpy(&va, a + i, sizeof(simd)); \
+            STORE; \
+        } \
+    } else if (b_scalar == false) { \
+        for (; i + VEC_LANES(T) <= len; i += VEC_LANES(T)) { \
+            memcpy(&vb, b + i, sizeof(simd)); \
+            STORE; \
+        } \
+    }
+
+// + and - give the same bits for signed and unsigned ints so signed types use the unsigned kernels
+#define VEC_KERNEL_ARITH(NAME, T, OP) \
+    VEC_TARGET static void NAME(size_t len, const void *a_items, bool a_scalar, const void *b_items, bool b_scalar, void *out_items) { \
+        T *out = out_items; \
+        VEC_KERNEL_LOOP(T, { simd r = va OP vb; memcpy(out + i, &r, sizeof(simd)); }) \
+        for (; i < len; i++) out[i] = a[a_scalar ? 0 : i] OP b[b_scalar ? 0 : i]; \
+    }
+
+// masks are narrowed to one u8 per item
+#define VEC_KERNEL_CMP(NAME, T, OP) \
+    VEC_TARGET static void NAME(size_t len, const void *a_items, bool a_scalar, const void *b_items, bool b_scalar, void *out_items) { \
+        typedef uint8_t mask __attribute__((vector_size(VEC_LANES(T)))); \
+        uint8_t *out = out_items; \
+        VEC_KERNEL_LOOP(T, { mask r = __builtin_convertvector(va OP vb, mask) & 1; memcpy(out + i, &r, sizeof(mask)); }) \
+        for (; i < len; i++) out[i] = a[a_scalar ? 0 : i] OP b[b_scalar ? 0 : i]; \
+    }
+
+VEC_KERNEL_ARITH(add_u8, uint8_t, +)
+VEC_KERNEL_ARITH(add_u16, uint16_t, +)
+VEC_KERNEL_ARITH(add_u32, uint32_t, +)
+VEC_KERNEL_ARITH(add_u64, uint64_t, +)
+VEC_KERNEL_ARITH(add_f32, float, +)
+VEC_KERNEL_ARITH(add_f64, double, +)
+
+VEC_KERNEL_ARITH(sub_u8, uint8_t, -)
+VEC_KERNEL_ARITH(sub_u16, uint16_t, -)
+VEC_KERNEL_ARITH(sub_u32, uint32_t, -)
+VEC_KERNEL_ARITH(sub_u64, uint64_t, -)
+VEC_KERNEL_ARITH(sub_f32, float, -)
+VEC_KERNEL_ARITH(sub_f64, double, -)
+
+VEC_KERNEL_CMP(equal_u8, uint8_t, ==)
+VEC_KERNEL_CMP(equal_u16, uint16_t, ==)
+VEC_KERNEL_CMP(equal_u32, uint32_t, ==)
+VEC_KERNEL_CMP(equal_u64, uint64_t, ==)
+VEC_KERNEL_CMP(equal_f32, float, ==)
+VEC_KERNEL_CMP(equal_f64, double, ==)
+
+VEC_KERNEL_CMP(less_equal_u8, uint8_t, <=)
+VEC_KERNEL_CMP(less_equal_u16, uint16_t, <=)
+VEC_KERNEL_CMP(less_equal_u32, uint32_t, <=)
+VEC_KERNEL_CMP(less_equal_u64, uint64_t, <=)
+VEC_KERNEL_CMP(less_equal_i8, int8_t, <=)
+VEC_KERNEL_CMP(less_equal_i16, int16_t, <=)
+VEC_KERNEL_CMP(less_equal_i32, int32_t, <=)
+VEC_KERNEL_CMP(less_equal_i64, int64_t, <=)
+VEC_KERNEL_CMP(less_equal_f32, float, <=)
+VEC_KERNEL_CMP(less_equal_f64, double, <=)
+
+static vec_kernel *const kernels[VEC_OP_PFX(_END_VEC_OP)][VAR_PFX(_END_VAR_TYPE_HEADER)] = {
+    [VEC_OP_PFX(ADD)] = {
+        [VAR_PFX(U8)] = add_u8, [VAR_PFX(U16)] = add_u16, [VAR_PFX(U32)] = add_u32, [VAR_PFX(U64)] = add_u64,
+        [VAR_PFX(I8)] = add_u8, [VAR_PFX(I16)] = add_u16, [VAR_PFX(I32)] = add_u32, [VAR_PFX(I64)] = add_u64,
+        [VAR_PFX(F32)] = add_f32, [VAR_PFX(F64)] = add_f64
+    },
+    [VEC_OP_PFX(SUB)] = {
+        [VAR_PFX(U8)] = sub_u8, [VAR_PFX(U16)] = sub_u16, [VAR_PFX(U32)] = sub_u32, [VAR_PFX(U64)] = sub_u64,
+        [VAR_PFX(I8)] = sub_u8, [VAR_PFX(I16)] = sub_u16, [VAR_PFX(I32)] = sub_u32, [VAR_PFX(I64)] = sub_u64,
+        [VAR_PFX(F32)] = sub_f32, [VAR_PFX(F64)] = sub_f64
+    },
+    [VEC_OP_PFX(EQUAL)] = {
+        [VAR_PFX(U8)] = equal_u8, [VAR_PFX(U16)] = equal_u16, [VAR_PFX(U32)] = equal_u32, [VAR_PFX(U64)] = equal_u64,
+        [VAR_PFX(I8)] = equal_u8, [VAR_PFX(I16)] = equal_u16, [VAR_PFX(I32)] = equal_u32, [VAR_PFX(I64)] = equal_u64,
+        [VAR_PFX(F32)] = equal_f32, [VAR_PFX(F64)] = equal_f64
+    },
+    [VEC_OP_PFX(LESSEQUAL)] = {
+        [VAR_PFX(U8)] = less_equal_u8, [VAR_PFX(U16)] = less_equal_u16, [VAR_PFX(U32)] = less_equal_u32, [VAR_PFX(U64)] = less_equal_u64,
+        [VAR_PFX(I8)] = less_equal_i8, [VAR_PFX(I16)] = less_equal_i16, [VAR_PFX(I32)] = less_equal_i32, [VAR_PFX(I64)] = less_equal_i64,
+        [VAR_PFX(F32)] = less_equal_f32, [VAR_PFX(F64)] = less_equal_f64
+    }
+};
+
+void vec_op_items(vec_op op, var_type_header header, size_t len, const void *const a, bool a_scalar, const void *const b, bool b_scalar, void *const out) {
+    if (len > 0) kernels[op][header](len, a, a_scalar, b, b_scalar, out);
+}
+
+static vec *vec_op_run(region *const r, vec_op op, var_type_header header, size_t len, const void *const a, bool a_scalar, const void *const b, bool b_scalar) {
+    bool cmp = op == VEC_OP_PFX(EQUAL) || op == VEC_OP_PFX(LESSEQUAL);
+    vec *out = vec_init_region(r, cmp ? VAR_PFX(U8) : header, len);
+    out->len = len;
+    vec_op_items(op, header, len, a, a_scalar, b, b_scalar, out->items);
+    return out;
+}
+
+vec *vec_op_vec(region *const r, vec_op op, const vec *const left, const vec *const right) {
+    size_t len = left->len < right->len ? left->len : right->len;
+    return vec_op_run(r, op, left->header, len, left->items, false, right->items, false);
+}
+
+vec *vec_op_scalar(region *const r, vec_op op, const vec *const v, const void *const scalar, bool scalar_left) {
+    if (scalar_left == true) return vec_op_run(r, op, v->header, v->len, scalar, true, v->items, false);
+    return vec_op_run(r, op, v->header, v->len, v->items, false, scalar, true);
+}
@@ -0,0 +1,84 @@
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "def.h"
+#include "type.h"
+#include "region.h"
+#include "slab.h"
+
+typedef struct _vec {
+    var_type_header header; // type of every item
+    size_t item_size, len, size; // bytes per item, items used, items allocated
+    uint8_t *items; // aligned for simd loads
+    region *r; // null for the heap, otherwise freed with the frame that owns the region
+    atomic_size_t refs; // owners, the last one frees a heap vec
+} vec;
+
+size_t vec_item_size(var_type_header header); // 0 if the type cannot be packed
+
+vec *vec_init(var_type_header header, size_t size);
+
+vec *vec_init_region(region *const r, var_type_header header, size_t size); // heap if r is null
+
+inline size_t vec_items_bytes(size_t size, size_t item_size) {
+    // a multiple of the cache line so the items are cache line aligned
+    size_t bytes = (size * item_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    return bytes > 0 ? bytes : CACHE_LINE_SIZE;
+}
+
+inline vec *vec_retain(vec *const v) {
+    if (v != NULL) atomic_fetch_add_explicit(&v->refs, 1, memory_order_relaxed);
+    return v;
+}
+
+inline void vec_free(vec *v) {
+    // drops a ref, vecs in a region stay until the region is freed
+    if (v == NULL || atomic_fetch_sub_explicit(&v->refs, 1, memory_order_acq_rel) != 1 || v->r != NULL) return;
+    slab_free(v->items, vec_items_bytes(v->size, v->item_size));
+    slab_free(v, sizeof(vec));
+}
+
+inline bool vec_unique(vec *const v) {
+    // the only owner can update the items in place
+    return atomic_load_explicit(&v->refs, memory_order_acquire) == 1;
+}
+
+vec *vec_copy(const vec *const v); // always on the heap
+
+inline vec *vec_promote(vec *const v) {
+    // the ref to a vec in a region moves to a copy on the heap
+    if (v == NULL || v->r == NULL) return v;
+    vec *copy = vec_copy(v);
+    vec_free(v);
+    return copy;
+}
+
+void vec_push(vec **const v, const void *const item); // item is item_size bytes
+
+inline void *vec_get(const vec *const v, size_t idx) {
+    return v->items + idx * v->item_size;
+}
+
+#define VEC_OP_PFX(NAME) VEC_OP_##NAME
+
+typedef enum {
+    VEC_OP_PFX(ADD),
+    VEC_OP_PFX(SUB),
+    VEC_OP_PFX(EQUAL), // items are u8 0 or 1
+    VEC_OP_PFX(LESSEQUAL),
+    VEC_OP_PFX(_END_VEC_OP)
+} vec_op;
+
+// runs the kernel for len items, out is len items of header or u8 for comparisons
+void vec_op_items(vec_op op, var_type_header header, size_t len, const void *const a, bool a_scalar, const void *const b, bool b_scalar, void *const out);
+
+// lengths must match, the result has the shorter len
+vec *vec_op_vec(region *const r, vec_op op, const vec *const left, const vec *const right);
+
+// scalar is item_size bytes of the vec type
+vec *vec_op_scalar(region *const r, vec_op op, const vec *const v, const void *const scalar, bool scalar_left);
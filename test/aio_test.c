@@ -0,0 +1,101 @@
+#define _GNU_SOURCE
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "test.h"
+#include "../src/out.h"
+
+// many buffers worth so writes wait on the pipe while the timer goes off
+#define NUM_LINES 400000
+
+#define READ_CHUNK 4096
+
+#define READ_DELAY_US 20
+
+#define TIMER_US 50
+
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len, size;
+} reader;
+
+static volatile sig_atomic_t alarms;
+
+static void on_alarm(int sig) {
+    (void) sig;
+    alarms++;
+}
+
+static void *reader_loop(void *arg) {
+    // small slow reads keep the pipe full
+    reader *r = arg;
+    ssize_t n;
+    for (;;) {
+        if (r->size - r->len < READ_CHUNK) r->buf = realloc(r->buf, r->size = r->size * 2 + READ_CHUNK);
+        if ((n = read(r->fd, r->buf + r->len, READ_CHUNK)) <= 0) break;
+        r->len += n;
+        usleep(READ_DELAY_US);
+    }
+    return NULL;
+}
+
+static int write_lines(const char *const io, reader *const r, aio_backend *const backend) {
+    // null io is the default backend
+    if (io == NULL) unsetenv("SC_IO");
+    else setenv("SC_IO", io, 1);
+    int fds[2];
+    TEST_CHECK(pipe(fds) == 0);
+    *r = (reader) { .fd = fds[0] };
+    // only this thread takes the alarms, without restart every blocking call in aio can see EINTR
+    sigset_t mask, old;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old);
+    pthread_t t;
+    TEST_CHECK(pthread_create(&t, NULL, reader_loop, r) == 0);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    aio *a = aio_init(AIO_DEPTH);
+    *backend = a->backend;
+    out_buf *o = out_buf_init(fds[1], a);
+    struct itimerval timer = { .it_interval.tv_usec = TIMER_US, .it_value.tv_usec = TIMER_US }, off = { 0 };
+    TEST_CHECK(setitimer(ITIMER_REAL, &timer, NULL) == 0);
+    bool ok = true;
+    for (uint64_t i = 0; i < NUM_LINES && ok == true; i++) ok = out_buf_u64(o, i * 2654435761u) && out_buf_write(o, "\n", 1);
+    ok = out_buf_free(o) && ok;
+    setitimer(ITIMER_REAL, &off, NULL);
+    aio_free(a);
+    close(fds[1]);
+    pthread_join(t, NULL);
+    close(fds[0]);
+    TEST_CHECK(ok == true);
+    return 0;
+}
+
+static int check_lines(const reader *const r) {
+    const char *p = r->buf, *end = r->buf + r->len;
+    for (uint64_t i = 0; i < NUM_LINES; i++) {
+        char *next;
+        TEST_CHECK(p < end && strtoull(p, &next, 10) == i * 2654435761u && *next == '\n');
+        p = next + 1;
+    }
+    TEST_CHECK(p == end);
+    return 0;
+}
+
+int main(void) {
+    // the same bytes come out of io_uring and the epoll fallback while signals interrupt both
+    struct sigaction sa = { .sa_handler = on_alarm };
+    sigemptyset(&sa.sa_mask);
+    TEST_CHECK(sigaction(SIGALRM, &sa, NULL) == 0);
+    reader uring, epoll;
+    aio_backend uring_backend, epoll_backend;
+    if (write_lines(NULL, &uring, &uring_backend) != 0 || write_lines("epoll", &epoll, &epoll_backend) != 0) return 1;
+    TEST_CHECK(epoll_backend == AIO_BACKEND_PFX(EPOLL) && alarms > 0);
+    if (check_lines(&uring) != 0 || check_lines(&epoll) != 0) return 1;
+    TEST_CHECK(uring.len == epoll.len && memcmp(uring.buf, epoll.buf, uring.len) == 0);
+    free(uring.buf);
+    free(epoll.buf);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <time.h>
+#include "../src/chan.h"
+
+// messages per second through a chan and through a ring under one mutex, the same threads and capacity for both
+
+#define NUM_MSGS 2000000
+
+#define BENCH_CAP 1024
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_full, not_empty;
+    bool closed;
+    size_t head, len;
+    var_data items[BENCH_CAP];
+} mutex_queue;
+
+static void mutex_send(mutex_queue *const q, var_data data) {
+    pthread_mutex_lock(&q->lock);
+    while (q->len == BENCH_CAP) pthread_cond_wait(&q->not_full, &q->lock);
+    q->items[(q->head + q->len++) % BENCH_CAP] = data;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static bool mutex_recv(mutex_queue *const q, var_data *const data) {
+    pthread_mutex_lock(&q->lock);
+    while (q->len == 0 && q->closed == false) pthread_cond_wait(&q->not_empty, &q->lock);
+    bool ok = q->len > 0;
+    if (ok) {
+        *data = q->items[q->head];
+        q->head = (q->head + 1) % BENCH_CAP;
+        q->len--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+static void mutex_close(mutex_queue *const q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+typedef struct {
+    bool use_chan;
+    chan *c;
+    mutex_queue *q;
+    size_t num;
+    uint64_t sum;
+} bench_arg;
+
+static void *bench_send(void *arg) {
+    bench_arg *a = arg;
+    for (size_t i = 0; i < a->num; i++) {
+        if (a->use_chan) chan_send(a->c, (var_data) { .u64 = i });
+        else mutex_send(a->q, (var_data) { .u64 = i });
+    }
+    return NULL;
+}
+
+static void *bench_recv(void *arg) {
+    bench_arg *a = arg;
+    var_data data;
+    if (a->use_chan) while (chan_recv(a->c, &data)) a->sum += data.u64;
+    else while (mutex_recv(a->q, &data)) a->sum += data.u64;
+    return NULL;
+}
+
+static double bench_run(bool use_chan, size_t num_senders, size_t num_receivers) {
+    chan *c = use_chan ? chan_init(NULL, BENCH_CAP) : NULL;
+    mutex_queue *q = calloc(1, sizeof(mutex_queue));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_t senders[num_senders], receivers[num_receivers];
+    bench_arg send_args[num_senders], recv_args[num_receivers];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < num_receivers; i++) {
+        recv_args[i] = (bench_arg) { .use_chan = use_chan, .c = c, .q = q };
+        pthread_create(&receivers[i], NULL, bench_recv, &recv_args[i]);
+    }
+    for (size_t i = 0; i < num_senders; i++) {
+        send_args[i] = (bench_arg) { .use_chan = use_chan, .c = c, .q = q, .num = NUM_MSGS / num_senders };
+        pthread_create(&senders[i], NULL, bench_send, &send_args[i]);
+    }
+    for (size_t i = 0; i < num_senders; i++) pthread_join(senders[i], NULL);
+    if (use_chan) chan_close(c);
+    else mutex_close(q);
+    for (size_t i = 0; i < num_receivers; i++) pthread_join(receivers[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (c != NULL) chan_free(c);
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    free(q);
+    return NUM_MSGS / secs;
+}
+
+int main(void) {
+    static const size_t shapes[][2] = { { 1, 1 }, { 2, 2 }, { 4, 4 } };
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        double with_chan = bench_run(true, shapes[i][0], shapes[i][1]), with_mutex = bench_run(false, shapes[i][0], shapes[i][1]);
+        printf("{\"senders\":%lu,\"receivers\":%lu,\"chan_msgs_per_sec\":%.0f,\"mutex_msgs_per_sec\":%.0f}\n",
+            shapes[i][0], shapes[i][1], with_chan, with_mutex);
+    }
+    return 0;
+}
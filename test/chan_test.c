@@ -0,0 +1,94 @@
+#include "test.h"
+#include "../src/chan.h"
+
+#define NUM_SENDERS 4
+
+#define NUM_RECEIVERS 4
+
+#define NUM_SENDS 10000
+
+// past a few blocks so the spsc list links and reuses them
+#define NUM_SPSC_SENDS (CHAN_BLOCK_SIZE * 3 + 7)
+
+static var_data sender(void *arg) {
+    chan *c = arg;
+    for (uint64_t i = 1; i <= NUM_SENDS; i++) if (chan_send(c, (var_data) { .u64 = i }) == false) return (var_data) { .u64 = 0 };
+    return (var_data) { .u64 = 1 };
+}
+
+static var_data receiver(void *arg) {
+    // the sum of what it got, each value is counted in the high bits
+    chan *c = arg;
+    var_data data;
+    uint64_t sum = 0;
+    while (chan_recv(c, &data)) sum += data.u64 + ((uint64_t) 1 << 40);
+    return (var_data) { .u64 = sum };
+}
+
+static var_data spsc_sender(void *arg) {
+    chan *c = arg;
+    for (uint64_t i = 0; i < NUM_SPSC_SENDS; i++) chan_send(c, (var_data) { .u64 = i });
+    chan_close(c);
+    return (var_data) { .u64 = 0 };
+}
+
+static int test_try(pool *const p) {
+    chan *c = chan_init(p, 3);
+    var_data data;
+    TEST_CHECK(chan_try_recv(c, &data) == false);
+    for (uint64_t i = 0; i < 4; i++) TEST_CHECK(chan_try_send(c, (var_data) { .u64 = i }) == true);
+    TEST_CHECK(chan_try_send(c, (var_data) { .u64 = 4 }) == false);
+    TEST_CHECK(chan_try_recv(c, &data) == true && data.u64 == 0);
+    TEST_CHECK(chan_try_send(c, (var_data) { .u64 = 4 }) == true);
+    chan_close(c);
+    TEST_CHECK(chan_try_send(c, (var_data) { .u64 = 5 }) == false);
+    for (uint64_t i = 1; i <= 4; i++) TEST_CHECK(chan_recv(c, &data) == true && data.u64 == i);
+    TEST_CHECK(chan_recv(c, &data) == false);
+    chan_free(c);
+    return 0;
+}
+
+static int test_mpmc(pool *const p) {
+    // a small ring so senders and receivers park on each other
+    chan *c = chan_init(p, 8);
+    thread *senders[NUM_SENDERS], *receivers[NUM_RECEIVERS];
+    for (size_t i = 0; i < NUM_RECEIVERS; i++) TEST_CHECK((receivers[i] = thread_spawn(p, NULL, receiver, c)) != NULL);
+    for (size_t i = 0; i < NUM_SENDERS; i++) TEST_CHECK((senders[i] = thread_spawn(p, NULL, sender, c)) != NULL);
+    for (size_t i = 0; i < NUM_SENDERS; i++) {
+        TEST_CHECK(thread_join(senders[i]).u64 == 1);
+        thread_free(senders[i]);
+    }
+    chan_close(c);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < NUM_RECEIVERS; i++) {
+        sum += thread_join(receivers[i]).u64;
+        thread_free(receivers[i]);
+    }
+    uint64_t count = sum >> 40, values = sum & (((uint64_t) 1 << 40) - 1);
+    TEST_CHECK(count == (uint64_t) NUM_SENDERS * NUM_SENDS);
+    TEST_CHECK(values == (uint64_t) NUM_SENDERS * NUM_SENDS * (NUM_SENDS + 1) / 2);
+    chan_free(c);
+    return 0;
+}
+
+static int test_spsc(pool *const p) {
+    // received in order by a thread that is not green
+    chan *c = chan_init_spsc(p);
+    thread *t = thread_spawn(p, NULL, spsc_sender, c);
+    TEST_CHECK(t != NULL);
+    var_data data;
+    uint64_t next = 0;
+    while (chan_recv(c, &data)) TEST_CHECK(data.u64 == next++);
+    TEST_CHECK(next == NUM_SPSC_SENDS);
+    thread_join(t);
+    thread_free(t);
+    chan_free(c);
+    return 0;
+}
+
+int main(void) {
+    pool *p = pool_init(4);
+    if (test_try(p) != 0 || test_mpmc(p) != 0 || test_spsc(p) != 0) return 1;
+    pool_free(p);
+    return 0;
+}
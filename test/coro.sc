@@ -0,0 +1,9 @@
+
+w: { (n::u64)[u64] a: n + u64 $ 1
+    1 <& @[n; " "; a; "\n"]
+    b: a + a
+    1 <& @[n; " "; b; "\n"]
+    a + b
+}
+
+w(u64 $ 7)
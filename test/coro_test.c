@@ -0,0 +1,89 @@
+#define _GNU_SOURCE
+
+#include <unistd.h>
+#include "test.h"
+
+// enough output to fill the pipe while the reader holds off so writes stay in flight
+#define NUM_COROS 20000
+
+#define READER_DELAY_US 100000
+
+typedef struct {
+    int fd;
+    char *buf;
+    size_t len, size;
+} reader;
+
+static void *reader_loop(void *arg) {
+    reader *r = arg;
+    usleep(READER_DELAY_US);
+    ssize_t n;
+    for (;;) {
+        if (r->len == r->size) r->buf = realloc(r->buf, r->size = r->size * 2 + 4096);
+        if ((n = read(r->fd, r->buf + r->len, r->size - r->len)) <= 0) break;
+        r->len += n;
+    }
+    return NULL;
+}
+
+static int check_output(const reader *const r, bool *const interleaved) {
+    // each call writes n a then n 2a, calls are only interleaved if one suspended between its writes
+    uint8_t *seen = calloc(NUM_COROS, sizeof(uint8_t));
+    size_t open = 0, lines = 0;
+    *interleaved = false;
+    for (const char *p = r->buf, *end = r->buf + r->len; p < end; lines++) {
+        char *next;
+        uint64_t n = strtoull(p, &next, 10), v = strtoull(next, &next, 10);
+        TEST_CHECK(*next == '\n' && n < NUM_COROS);
+        p = next + 1;
+        if (seen[n] == 0) {
+            TEST_CHECK(v == n + 1);
+            if (open > 0) *interleaved = true;
+            open++;
+        } else {
+            TEST_CHECK(seen[n] == 1 && v == 2 * (n + 1));
+            open--;
+        }
+        seen[n]++;
+    }
+    TEST_CHECK(lines == NUM_COROS * 2 && open == 0);
+    free(seen);
+    return 0;
+}
+
+int main(void) {
+    int fds[2], out = dup(STDOUT_FILENO);
+    TEST_CHECK(out >= 0 && pipe(fds) == 0 && dup2(fds[1], STDOUT_FILENO) == STDOUT_FILENO);
+    close(fds[1]);
+    reader r = { .fd = fds[0] };
+    pthread_t t;
+    TEST_CHECK(pthread_create(&t, NULL, reader_loop, &r) == 0);
+    test_module m;
+    TEST_CHECK(test_module_init(&m, "coro.sc") == true);
+    TEST_CHECK(m.last != NULL && m.last->type == AST_PFX(CALL));
+    aio_backend backend = m.state->io->backend;
+    // the arg of each call is set in the literal before the frame is made
+    ast_node *arg = m.last->data.call->args[0]->data.op->right;
+    ir_coro_frame **frames = malloc(sizeof(ir_coro_frame*) * NUM_COROS);
+    var_data *rets = malloc(sizeof(var_data) * NUM_COROS);
+    for (size_t i = 0; i < NUM_COROS; i++) {
+        arg->data.intv = i;
+        TEST_CHECK((frames[i] = run_async(m.state, m.root, m.last->data.call)) != NULL);
+    }
+    run_await(m.state, frames, NUM_COROS, rets);
+    for (size_t i = 0; i < NUM_COROS; i++) TEST_CHECK(rets[i].u64 == 3 * (i + 1));
+    free(frames);
+    free(rets);
+    // the buffers go out as the state is freed
+    test_module_free(&m);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+    pthread_join(t, NULL);
+    close(fds[0]);
+    bool interleaved;
+    if (check_output(&r, &interleaved) != 0) return 1;
+    // blocking writes of the epoll fallback finish on submit so nothing suspends
+    if (backend == AIO_BACKEND_PFX(URING)) TEST_CHECK(interleaved == true);
+    free(r.buf);
+    return 0;
+}
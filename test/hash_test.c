@@ -0,0 +1,127 @@
+#include "test.h"
+
+// a table of this size is one group, every probe reads the copy of the group past the end
+#define SMALL_SIZE HASH_GROUP_SIZE
+
+#define WRAP_SIZE 64
+
+// more than fit in the last group so the probe wraps to the start
+#define NUM_WRAP_KEYS (HASH_GROUP_SIZE + 8)
+
+static string *key_of(const char *const prefix, size_t i) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s%lu", prefix, i);
+    return string_from_c(buf);
+}
+
+static bool has(const hash *const h, const string *const key, var_value want) {
+    var_value v;
+    return hash_get(h, key, &v) == HASH_STATUS_PFX(OK) && v == want;
+}
+
+static bool ctrl_mirrored(const hash *const h) {
+    return memcmp(h->ctrl, h->ctrl + h->size, HASH_GROUP_SIZE) == 0;
+}
+
+static int test_one_group(void) {
+    // fills to the load limit, the next key grows the table
+    hash *h = hash_init(1);
+    TEST_CHECK(h->size == SMALL_SIZE);
+    size_t max = SMALL_SIZE * HASH_MAX_LOAD_PERCENT / 100;
+    string *keys[SMALL_SIZE];
+    for (size_t i = 0; i < max; i++) hash_set(h, keys[i] = key_of("k", i), i);
+    TEST_CHECK(h->size == SMALL_SIZE && h->used == max && ctrl_mirrored(h));
+    for (size_t i = 0; i < max; i++) TEST_CHECK(has(h, keys[i], i));
+    string *missing = string_from_c("missing");
+    TEST_CHECK(has(h, missing, 0) == false);
+    hash_set(h, keys[max] = key_of("k", max), max);
+    TEST_CHECK(h->size == SMALL_SIZE * REHASH_SIZE_MULTIPLIER && ctrl_mirrored(h));
+    for (size_t i = 0; i <= max; i++) TEST_CHECK(has(h, keys[i], i));
+    for (size_t i = 0; i <= max; i++) string_free(keys[i]);
+    string_free(missing);
+    hash_free(h);
+    return 0;
+}
+
+static int test_wrap(void) {
+    // keys that all start at the last slot fill the end and wrap, removes shift them back across it
+    hash *h = hash_init(WRAP_SIZE / 2);
+    TEST_CHECK(h->size == WRAP_SIZE);
+    string *keys[NUM_WRAP_KEYS];
+    size_t found = 0;
+    for (size_t i = 0; found < NUM_WRAP_KEYS; i++) {
+        string *k = key_of(found % 2 == 0 ? "wrap" : "a key longer than the inline size ", i);
+        if (((hash_key(k->buffer, k->len) >> 7) & (WRAP_SIZE - 1)) != WRAP_SIZE - 1) {
+            string_free(k);
+            continue;
+        }
+        keys[found] = k;
+        hash_set(h, k, found++);
+    }
+    TEST_CHECK(h->size == WRAP_SIZE && h->used == NUM_WRAP_KEYS && ctrl_mirrored(h));
+    TEST_CHECK(h->ctrl[WRAP_SIZE - 1] != HASH_CTRL_EMPTY && h->ctrl[0] != HASH_CTRL_EMPTY);
+    for (size_t i = 0; i < NUM_WRAP_KEYS; i++) TEST_CHECK(has(h, keys[i], i));
+    // the one in the home slot, one in the middle and the last
+    size_t removes[] = { 0, NUM_WRAP_KEYS / 2, NUM_WRAP_KEYS - 1 };
+    for (size_t r = 0; r < 3; r++) {
+        var_value v;
+        TEST_CHECK(hash_remove(h, keys[removes[r]], &v) == HASH_STATUS_PFX(OK) && v == removes[r]);
+        TEST_CHECK(hash_remove(h, keys[removes[r]], &v) == HASH_STATUS_PFX(KEY_NOT_FOUND));
+        TEST_CHECK(ctrl_mirrored(h));
+        for (size_t i = 0; i < NUM_WRAP_KEYS; i++) {
+            bool removed = i == removes[0] || (r >= 1 && i == removes[1]) || (r >= 2 && i == removes[2]);
+            TEST_CHECK(has(h, keys[i], i) == !removed);
+        }
+    }
+    // no gaps are left so the chain is as long as the keys in it
+    size_t run = 0;
+    for (size_t i = WRAP_SIZE - 1; h->ctrl[i & (WRAP_SIZE - 1)] != HASH_CTRL_EMPTY; i++) run++;
+    TEST_CHECK(run == NUM_WRAP_KEYS - 3);
+    for (size_t i = 0; i < NUM_WRAP_KEYS; i++) string_free(keys[i]);
+    hash_free(h);
+    return 0;
+}
+
+static int test_perfect(void) {
+    // 0 keys, one key, a bucket worth, a few and many, keys a byte apart
+    static const size_t counts[] = { 0, 1, HASH_PERFECT_BUCKET_KEYS, 7, 100 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t n = counts[c];
+        string *src = string_init(n * 8 + 1);
+        symbol_table *keys = symbol_table_init(DEFAULT_SYMBOL_TABLE_SIZE);
+        token t = { .type = TOKEN_PFX(VAR) };
+        for (size_t i = 0; i < n; i++) {
+            t.start_idx = src->len;
+            src->len += sprintf(src->buffer + src->len, "k%lu", i);
+            t.end_idx = src->len - 1;
+            symbol_table_bucket *b = symbol_table_insert(&keys, SYMBOL_PFX(KEY), &t, src);
+            TEST_CHECK(b != NULL);
+            b->idx.key = i;
+        }
+        hash_perfect *p = hash_perfect_init(keys);
+        TEST_CHECK(p->num_slots >= n);
+        size_t idx;
+        for (size_t i = 0; i < n; i++) {
+            string *k = key_of("k", i);
+            TEST_CHECK(hash_perfect_find(p, k, &idx) == HASH_STATUS_PFX(OK) && idx == i);
+            // one byte more or less is not a key
+            k->buffer[k->len++] = 'x';
+            TEST_CHECK(hash_perfect_find(p, k, &idx) == HASH_STATUS_PFX(KEY_NOT_IN_FIXED));
+            k->len -= 2;
+            if (i >= 10) TEST_CHECK(hash_perfect_find(p, k, &idx) == HASH_STATUS_PFX(OK) && idx == i / 10);
+            string_free(k);
+        }
+        string *missing = key_of("k", n);
+        TEST_CHECK(hash_perfect_find(p, missing, &idx) == HASH_STATUS_PFX(KEY_NOT_IN_FIXED));
+        string_free(missing);
+        hash_perfect_free(p);
+        symbol_table_free(keys);
+        string_free(src);
+    }
+    return 0;
+}
+
+int main(void) {
+    if (test_one_group() != 0 || test_wrap() != 0) return 1;
+    return test_perfect();
+}
@@ -0,0 +1,7 @@
+
+1 <& u64 $ 9223372036854775807
+1 <& "\n"
+1 <& u64 $ 9223372036854775808
+1 <& "\n"
+1 <& u64 $ 18446744073709551615
+1 <& "\n"
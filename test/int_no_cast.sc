@@ -0,0 +1,2 @@
+
+1 <& 18446744073709551615
@@ -0,0 +1,2 @@
+
+1 <& u64 $ 18446744073709551616
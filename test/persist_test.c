@@ -0,0 +1,122 @@
+#include "test.h"
+#include "../src/hamt.h"
+#include "../src/pvec.h"
+
+// past the tail, the first root split and a third level
+#define PVEC_LEN (PVEC_WIDTH * PVEC_WIDTH + PVEC_WIDTH + 3)
+
+#define HAMT_LEN 2000
+
+// every version made on the way is kept and checked against the values it was made with
+static const size_t snaps[] = { 0, 1, PVEC_WIDTH - 1, PVEC_WIDTH, PVEC_WIDTH + 1, PVEC_WIDTH * 2, PVEC_WIDTH * PVEC_WIDTH, PVEC_WIDTH * PVEC_WIDTH + PVEC_WIDTH };
+
+#define NUM_SNAPS (sizeof(snaps) / sizeof(snaps[0]))
+
+static bool pvec_is(const pvec *const v, size_t len, size_t changed, var_value changed_to) {
+    // items are their index except the one at changed
+    if (v->len != len) return false;
+    for (size_t i = 0; i < len; i++)
+        if (pvec_get(v, i) != (i == changed ? changed_to : var_value_from_int(i))) return false;
+    return true;
+}
+
+static int test_pvec(void) {
+    pvec *versions[NUM_SNAPS], *v = pvec_init();
+    size_t s = 0;
+    for (size_t i = 0; i <= PVEC_LEN; i++) {
+        if (s < NUM_SNAPS && snaps[s] == i) versions[s++] = pvec_copy(v);
+        if (i == PVEC_LEN) break;
+        pvec *next = pvec_push(v, var_value_from_int(i));
+        pvec_free(v);
+        v = next;
+    }
+    for (s = 0; s < NUM_SNAPS; s++) TEST_CHECK(pvec_is(versions[s], snaps[s], SIZE_MAX, 0));
+    // a set in the tree, at the edge of the tail and in it
+    size_t sets[] = { 0, PVEC_WIDTH, PVEC_LEN - PVEC_WIDTH, PVEC_LEN - 4, PVEC_LEN - 1 };
+    for (size_t i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+        pvec *set = pvec_set(v, sets[i], var_value_from_int(-1));
+        TEST_CHECK(pvec_is(set, PVEC_LEN, sets[i], var_value_from_int(-1)));
+        TEST_CHECK(pvec_is(v, PVEC_LEN, SIZE_MAX, 0));
+        pvec_free(set);
+    }
+    // a transient changes its own copies only
+    pvec *t = pvec_transient(v);
+    for (size_t i = 0; i < PVEC_LEN; i += 3) pvec_set_in_place(t, i, var_value_from_int(-2));
+    for (size_t i = 0; i < PVEC_WIDTH; i++) pvec_push_in_place(t, var_value_from_int(-3));
+    TEST_CHECK(t->len == PVEC_LEN + PVEC_WIDTH && pvec_get(t, 3) == var_value_from_int(-2) && pvec_get(t, PVEC_LEN) == var_value_from_int(-3));
+    TEST_CHECK(pvec_is(v, PVEC_LEN, SIZE_MAX, 0));
+    for (s = 0; s < NUM_SNAPS; s++) TEST_CHECK(pvec_is(versions[s], snaps[s], SIZE_MAX, 0));
+    pvec_free(t);
+    for (s = 0; s < NUM_SNAPS; s++) pvec_free(versions[s]);
+    pvec_free(v);
+    return 0;
+}
+
+static string *hamt_key(size_t i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key%lu", i);
+    return string_from_c(buf);
+}
+
+static bool hamt_has(const hamt *const h, size_t i, bool want, var_value value) {
+    string *k = hamt_key(i);
+    var_value v;
+    bool found = hamt_get(h, k, &v) == HASH_STATUS_PFX(OK);
+    string_free(k);
+    return found == want && (found == false || v == value);
+}
+
+static int test_hamt(void) {
+    hamt *half = NULL, *h = hamt_init();
+    for (size_t i = 0; i < HAMT_LEN; i++) {
+        if (i == HAMT_LEN / 2) half = hamt_copy(h);
+        string *k = hamt_key(i);
+        hamt *next = hamt_set(h, k, var_value_from_int(i));
+        hamt_free(h);
+        h = next;
+        string_free(k);
+    }
+    TEST_CHECK(half->len == HAMT_LEN / 2 && h->len == HAMT_LEN);
+    for (size_t i = 0; i < HAMT_LEN; i++) {
+        TEST_CHECK(hamt_has(half, i, i < HAMT_LEN / 2, var_value_from_int(i)));
+        TEST_CHECK(hamt_has(h, i, true, var_value_from_int(i)));
+    }
+    // a replace and a remove leave the version they were made from alone
+    string *k = hamt_key(7);
+    hamt *replaced = hamt_set(h, k, var_value_from_int(-1)), *removed = hamt_remove(replaced, k);
+    string_free(k);
+    TEST_CHECK(replaced->len == HAMT_LEN && removed->len == HAMT_LEN - 1);
+    TEST_CHECK(hamt_has(h, 7, true, var_value_from_int(7)));
+    TEST_CHECK(hamt_has(replaced, 7, true, var_value_from_int(-1)));
+    TEST_CHECK(hamt_has(removed, 7, false, 0));
+    // a transient that removes most keys and adds new ones
+    hamt *t = hamt_transient(h);
+    for (size_t i = 0; i < HAMT_LEN; i++) {
+        k = hamt_key(i);
+        if (i % 4 != 0) TEST_CHECK(hamt_remove_in_place(t, k) == HASH_STATUS_PFX(OK));
+        string_free(k);
+        k = hamt_key(i + HAMT_LEN);
+        hamt_set_in_place(t, k, var_value_from_int(-2));
+        string_free(k);
+    }
+    TEST_CHECK(t->len == HAMT_LEN / 4 + HAMT_LEN);
+    for (size_t i = 0; i < HAMT_LEN; i++) {
+        TEST_CHECK(hamt_has(t, i, i % 4 == 0, var_value_from_int(i)));
+        TEST_CHECK(hamt_has(t, i + HAMT_LEN, true, var_value_from_int(-2)));
+        TEST_CHECK(hamt_has(h, i, true, var_value_from_int(i)));
+        TEST_CHECK(hamt_has(h, i + HAMT_LEN, false, 0));
+        TEST_CHECK(hamt_has(half, i, i < HAMT_LEN / 2, var_value_from_int(i)));
+    }
+    TEST_CHECK(h->len == HAMT_LEN && half->len == HAMT_LEN / 2);
+    hamt_free(t);
+    hamt_free(removed);
+    hamt_free(replaced);
+    hamt_free(half);
+    hamt_free(h);
+    return 0;
+}
+
+int main(void) {
+    if (test_pvec() != 0) return 1;
+    return test_hamt();
+}
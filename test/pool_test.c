@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include "../src/pool.h"
+
+// more than a deque holds so some pushes fail and run inline
+#define NUM_TASKS (POOL_DEQUE_SIZE * 2)
+
+#define GRAIN 64
+
+#define MAX_LEN (GRAIN * 10 + 3)
+
+static atomic_size_t ran;
+
+static void count(void *arg) {
+    (void) arg;
+    atomic_fetch_add(&ran, 1);
+}
+
+static int test_fork(void) {
+    static pool_task tasks[NUM_TASKS];
+    pool *p = pool_init(4);
+    for (int round = 0; round < 100; round++) {
+        atomic_store(&ran, 0);
+        for (size_t i = 0; i < NUM_TASKS; i++) {
+            pool_task_setup(&tasks[i], count, NULL);
+            pool_fork(p, &tasks[i]);
+        }
+        for (size_t i = 0; i < NUM_TASKS; i++) pool_join(p, &tasks[i]);
+        if (atomic_load(&ran) != NUM_TASKS || atomic_load(&p->pending) != 0) {
+            printf("pool round %d ran %lu pending %lu\n", round, atomic_load(&ran), atomic_load(&p->pending));
+            return 1;
+        }
+    }
+    pool_free(p);
+    return 0;
+}
+
+typedef struct {
+    atomic_size_t ends[MAX_LEN / GRAIN + 1]; // end of the range starting at each grain
+    atomic_uint visits[MAX_LEN];
+} ranges_seen;
+
+static void record(void *arg, size_t start, size_t end) {
+    ranges_seen *s = arg;
+    atomic_store(&s->ends[start / GRAIN], end);
+    for (size_t i = start; i < end; i++) atomic_fetch_add(&s->visits[i], 1);
+}
+
+static int test_for(void) {
+    // ranges only depend on the len and grain, never on the number of workers
+    static const size_t lens[] = { 0, 1, GRAIN - 1, GRAIN, GRAIN + 1, GRAIN * 2, MAX_LEN };
+    static const size_t workers[] = { 1, 2, 4 };
+    static ranges_seen seen[3];
+    for (size_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (size_t w = 0; w < 3; w++) {
+            memset(&seen[w], 0, sizeof(ranges_seen));
+            pool *p = pool_init(workers[w]);
+            pool_for(p, lens[l], GRAIN, record, &seen[w]);
+            pool_free(p);
+            for (size_t i = 0; i < lens[l]; i++) {
+                if (atomic_load(&seen[w].visits[i]) != 1) {
+                    printf("pool_for len %lu workers %lu item %lu visited %u times\n", lens[l], workers[w], i, atomic_load(&seen[w].visits[i]));
+                    return 1;
+                }
+            }
+            for (size_t r = 0; r <= MAX_LEN / GRAIN; r++) {
+                size_t end = atomic_load(&seen[w].ends[r]), want = r * GRAIN < lens[l] ? (r + 1) * GRAIN : 0;
+                if (want > lens[l]) want = lens[l];
+                if (end != want || end != atomic_load(&seen[0].ends[r])) {
+                    printf("pool_for len %lu workers %lu range %lu ends at %lu\n", lens[l], workers[w], r, end);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    if (test_fork() != 0) return 1;
+    return test_for();
+}
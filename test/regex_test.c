@@ -0,0 +1,77 @@
+#include <time.h>
+#include "test.h"
+#include "../src/regex.h"
+
+// long enough that a backtracking matcher would never finish
+#define PATHOLOGICAL_LEN 1000000
+
+// the byte this far from the end picks the result, 2^16 dfa states can be reached
+#define TAIL_LEN 16
+
+#define EVICT_LEN 200000
+
+static double seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool match(const char *const pattern, const char *const data, size_t len) {
+    regex *re;
+    if (regex_compile(&re, pattern, strlen(pattern)) != REGEX_STATUS_PFX(OK)) return false;
+    bool m = regex_match(re, data, len);
+    regex_free(re);
+    return m;
+}
+
+static int test_pathological(void) {
+    // nested repeats over the same byte stay linear
+    char *data = malloc(PATHOLOGICAL_LEN + 1);
+    memset(data, 'a', PATHOLOGICAL_LEN);
+    double start = seconds();
+    TEST_CHECK(match("(a*)*b", data, PATHOLOGICAL_LEN) == false);
+    TEST_CHECK(match("^(a+)+$", data, PATHOLOGICAL_LEN) == true);
+    TEST_CHECK(match("(a|aa)*c", data, PATHOLOGICAL_LEN) == false);
+    TEST_CHECK(match("^(a|a?)+$", data, PATHOLOGICAL_LEN) == true);
+    data[PATHOLOGICAL_LEN - 1] = 'b';
+    TEST_CHECK(match("(a*)*b", data, PATHOLOGICAL_LEN) == true);
+    TEST_CHECK(match("^(a+)+$", data, PATHOLOGICAL_LEN) == false);
+    TEST_CHECK(match("^(a*)*a*b$", data, PATHOLOGICAL_LEN) == true);
+    TEST_CHECK(seconds() - start < 5);
+    free(data);
+    return 0;
+}
+
+static int test_evict(void) {
+    // a random walk over a and b reaches more dfa states than the cache holds
+    char pattern[8 + TAIL_LEN * 4];
+    size_t len = sprintf(pattern, "a");
+    for (size_t i = 1; i < TAIL_LEN; i++) len += sprintf(pattern + len, "[ab]");
+    len += sprintf(pattern + len, "$");
+    regex *re;
+    TEST_CHECK(regex_compile(&re, pattern, len) == REGEX_STATUS_PFX(OK));
+    char *data = malloc(EVICT_LEN);
+    uint64_t seed = 88172645463325252ull;
+    for (int round = 0; round < 8; round++) {
+        for (size_t i = 0; i < EVICT_LEN; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            data[i] = seed & 1 ? 'a' : 'b';
+        }
+        // alternate results, the scan can not stop early with the anchor at the end
+        data[EVICT_LEN - TAIL_LEN] = round % 2 == 0 ? 'a' : 'b';
+        TEST_CHECK(regex_match(re, data, EVICT_LEN) == (round % 2 == 0));
+        // a shorter input stays on the dfa, states made before the flushes are used again
+        TEST_CHECK(regex_match(re, data + EVICT_LEN - TAIL_LEN * 4, TAIL_LEN * 4) == (round % 2 == 0));
+    }
+    TEST_CHECK(re->flushes > 0);
+    regex_free(re);
+    free(data);
+    return 0;
+}
+
+int main(void) {
+    if (test_pathological() != 0) return 1;
+    return test_evict();
+}
@@ -0,0 +1,96 @@
+#include "test.h"
+
+#define NUM_PIECES 20000
+
+#define MAX_PIECE (ROPE_LEAF_LEN + 40)
+
+#define NUM_DOUBLINGS 12
+
+typedef struct {
+    size_t leaves;
+    bool ok;
+} rope_check;
+
+static size_t check_node(const rope *const r, rope_check *const c) {
+    // sides differ in depth by at most one and depth and len add up
+    if (r->type != ROPE_PFX(CONCAT)) {
+        c->leaves++;
+        if (r->depth != 0) c->ok = false;
+        return 0;
+    }
+    size_t left = check_node(r->concat.left, c), right = check_node(r->concat.right, c);
+    if ((left > right ? left - right : right - left) > 1 || r->depth != (left > right ? left : right) + 1) c->ok = false;
+    if (r->len != r->concat.left->len + r->concat.right->len) c->ok = false;
+    return r->depth;
+}
+
+static bool balanced(const rope *const r) {
+    // an avl tree of depth d has at least fib(d + 2) leaves so depth is at most 1.44 log2 of them
+    rope_check c = { .leaves = 0, .ok = true };
+    check_node(r, &c);
+    size_t a = 1, b = 1;
+    for (size_t d = 0; d < r->depth; d++) {
+        b += a;
+        a = b - a;
+    }
+    return c.ok && c.leaves >= b;
+}
+
+static bool same(const rope *const r, const char *const want, size_t len) {
+    if (r->len != len) return false;
+    char *got = malloc(len + 1);
+    rope_copy_bytes(r, got);
+    bool eq = memcmp(got, want, len) == 0;
+    free(got);
+    return eq;
+}
+
+static int test_concat(void) {
+    // pieces go on both ends, small ones merge into leaves and long ones stay apart
+    char *want = malloc(NUM_PIECES * MAX_PIECE), piece[MAX_PIECE];
+    size_t len = 0;
+    uint32_t seed = 1;
+    rope *r = rope_from_buffer("", 0);
+    for (size_t i = 0; i < NUM_PIECES; i++) {
+        seed = seed * 1103515245 + 12345;
+        size_t piece_len = i % 5 == 4 ? ROPE_LEAF_LEN + (seed >> 16) % 40 : 1 + (seed >> 16) % ROPE_SMALL_LEN;
+        for (size_t j = 0; j < piece_len; j++) piece[j] = 'a' + (i + j) % 26;
+        rope *p = rope_from_buffer(piece, piece_len);
+        if (i % 3 == 2) {
+            memmove(want + piece_len, want, len);
+            memcpy(want, piece, piece_len);
+            r = rope_concat(p, r);
+        } else {
+            memcpy(want + len, piece, piece_len);
+            r = rope_concat(r, p);
+        }
+        len += piece_len;
+        if (i % 1000 == 999) TEST_CHECK(balanced(r));
+    }
+    TEST_CHECK(balanced(r) && same(r, want, len));
+    rope_free(r);
+    free(want);
+    return 0;
+}
+
+static int test_doubling(void) {
+    // a rope joined with itself shares both sides, depth grows by one each time
+    const char *const leaf = "a leaf longer than a small rope and the merge limit is not hit at all here";
+    rope *r = rope_from_buffer(leaf, strlen(leaf));
+    for (size_t i = 0; i < ROPE_LEAF_LEN / strlen(leaf) + 1; i++) r = rope_concat(r, rope_from_buffer(leaf, strlen(leaf)));
+    size_t start_depth = r->depth;
+    for (size_t i = 0; i < NUM_DOUBLINGS; i++) {
+        r = rope_concat(r, rope_copy(r));
+        TEST_CHECK(balanced(r) && r->depth <= start_depth + i + 2);
+    }
+    // and an unbalanced pair, a deep rope with one leaf
+    r = rope_concat(rope_from_buffer("x", 1), r);
+    TEST_CHECK(balanced(r) && r->len % strlen(leaf) == 1);
+    rope_free(r);
+    return 0;
+}
+
+int main(void) {
+    if (test_concat() != 0) return 1;
+    return test_doubling();
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# runs each script with every thread count and io backend (any SC_IO but epoll is io_uring)
+# stdout and the exit status must match the .out file
+# then runs each c test binary
+cd "$(dirname "$0")"
+fail=0
+for sc in *.sc; do
+    [ -e "$sc" ] || continue
+    want="${sc%.sc}.out"
+    for threads in 1 4; do
+        for io in uring epoll; do
+            got=$( { SC_THREADS=$threads SC_IO=$io ../sc "$sc" 2>/dev/null; echo "rc=$?"; } )
+            if [ "$got" != "$(cat "$want")" ]; then
+                echo "FAIL $sc SC_THREADS=$threads SC_IO=$io"
+                echo "$got"
+                fail=1
+            fi
+        done
+    done
+done
+for t in *_test; do
+    [ -x "$t" ] || continue
+    if ! ./"$t"; then
+        echo "FAIL $t"
+        fail=1
+    fi
+done
+[ $fail -eq 0 ] && echo "ok"
+exit $fail
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdio.h>
+#include "../src/parser.h"
+#include "../src/infer.h"
+#include "../src/run.h"
+
+// prints where the check failed and fails the test
+#define TEST_CHECK(COND) do { \
+    if (!(COND)) { \
+        fprintf(stderr, "%s:%d %s\n", __FILE__, __LINE__, #COND); \
+        return 1; \
+    } \
+} while (0)
+
+typedef struct {
+    run_state *state;
+    stack s;
+    run_frame *root;
+    const ast_node *last; // not run, left for the test
+} test_module;
+
+// parses, infers and runs a module from the test dir up to its last statement
+static inline bool test_module_init(test_module *const m, const char *const file) {
+    parser_state *pstate = parser_state_init();
+    parser_status ps = parse_module(pstate, file);
+    if (ps != PARSER_STATUS_PFX(DONE) && ps != PARSER_STATUS_PFX(NONE)) {
+        parser_state_free(pstate);
+        return false;
+    }
+    infer_state *istate = infer_state_init(pstate);
+    if (infer(istate) != INFER_STATUS_PFX(OK)) {
+        infer_state_free(istate);
+        return false;
+    }
+    m->state = run_state_init(istate);
+    stack_init(&m->s);
+    m->root = run_frame_init(&m->s, istate->p->root_fn, 0);
+    m->last = NULL;
+    for (ast_node_link *head = istate->p->root_fn->body_head; head != NULL; head = head->next) {
+        if (head->node == NULL) continue;
+        if (m->last != NULL) run_node(m->state, m->root, m->last);
+        m->last = head->node;
+    }
+    return true;
+}
+
+static inline void test_module_free(test_module *const m) {
+    run_frame_free(m->root);
+    stack_release(&m->s);
+    run_state_free(m->state);
+}
@@ -0,0 +1,71 @@
+#include "test.h"
+
+#define NUM_SPAWNS 64
+
+static _Atomic(thread*) parked = NULL;
+
+static void park_store(thread *t, void *arg) {
+    (void) arg;
+    atomic_store(&parked, t);
+}
+
+static var_data sleeper(void *arg) {
+    // parks until the test wakes it
+    thread_park(park_store, NULL);
+    return (var_data) { .u64 = (uintptr_t) arg + 1 };
+}
+
+static var_data yielder(void *arg) {
+    for (int i = 0; i < 10; i++) thread_yield();
+    return (var_data) { .u64 = (uintptr_t) arg };
+}
+
+static var_data joiner(void *arg) {
+    // parks in join until the yielder finishes
+    thread *t = arg;
+    var_data ret = thread_join(t);
+    thread_free(t);
+    return (var_data) { .u64 = ret.u64 * 2 };
+}
+
+static int test_park_wake(void) {
+    pool *p = pool_init(4);
+    thread *t = thread_spawn(p, NULL, sleeper, (void*) 41);
+    TEST_CHECK(t != NULL);
+    while (atomic_load(&parked) == NULL) if (pool_help(p) == false) sched_yield();
+    TEST_CHECK(atomic_load(&parked) == t && atomic_load(&t->state) == THREAD_STATE_PFX(PARKED));
+    thread_ready(t);
+    TEST_CHECK(thread_join(t).u64 == 42);
+    thread_free(t);
+    thread *joiners[NUM_SPAWNS];
+    for (size_t i = 0; i < NUM_SPAWNS; i++) {
+        thread *y = thread_spawn(p, NULL, yielder, (void*) i);
+        TEST_CHECK(y != NULL);
+        TEST_CHECK((joiners[i] = thread_spawn(p, NULL, joiner, y)) != NULL);
+    }
+    for (size_t i = 0; i < NUM_SPAWNS; i++) {
+        TEST_CHECK(thread_join(joiners[i]).u64 == i * 2);
+        thread_free(joiners[i]);
+    }
+    pool_free(p);
+    return 0;
+}
+
+static int test_run_spawn(void) {
+    // the body of each spawned call runs on a green thread
+    test_module m;
+    TEST_CHECK(test_module_init(&m, "spawn.sc") == true);
+    TEST_CHECK(m.last != NULL && m.last->type == AST_PFX(CALL));
+    uint64_t want = run_node(m.state, m.root, m.last).u64;
+    TEST_CHECK(want == 4181);
+    var_data spawned[NUM_SPAWNS];
+    for (size_t i = 0; i < NUM_SPAWNS; i++) spawned[i] = run_spawn(m.state, m.root, m.last->data.call);
+    for (size_t i = 0; i < NUM_SPAWNS; i++) TEST_CHECK(run_join(spawned[i]).u64 == want);
+    test_module_free(&m);
+    return 0;
+}
+
+int main(void) {
+    if (test_park_wake() != 0) return 1;
+    return test_run_spawn();
+}
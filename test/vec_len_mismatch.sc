@@ -0,0 +1,9 @@
+
+a: @[u64 $ 1; u64 $ 2; u64 $ 3]
+b: @[u64 $ 1; u64 $ 2; u64 $ 3; u64 $ 4]
+1 <& a
+1 <& "\n"
+c: a + b
+1 <& c
+1 <& "\n"
+1 <& @[a + b; "\n"]